@@ -0,0 +1,37 @@
+#include "allocations.hpp"
+
+#ifndef NDEBUG
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> allocations{0};
+
+uint64_t allocationCount() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+// Replacements for the global allocation functions. The array and nothrow
+// forms of the standard library forward to these.
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t align = static_cast<size_t>(alignment);
+    if (void* p = std::aligned_alloc(align, (size + align - 1) / align * align)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept                              { std::free(p); }
+void operator delete(void* p, size_t) noexcept                      { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept            { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept    { std::free(p); }
+#else
+uint64_t allocationCount() {
+    return 0;
+}
+#endif
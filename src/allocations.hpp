@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+// Number of heap allocations (operator new) made by the process so far.
+// Debug builds (NDEBUG not defined) replace the global operator new to count
+// them, so steady-state code such as the per-frame render path can be checked
+// for allocation churn. Release builds keep the standard allocator and always
+// report 0.
+uint64_t allocationCount();
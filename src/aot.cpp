@@ -0,0 +1,49 @@
+#include "aot.hpp"
+#include "hash.hpp"
+
+#include <algorithm>
+
+// Function-local, so generated sources can register from their static
+// initialisers whatever the initialisation order
+std::vector<const AotProgram*>& Aot::programs() {
+    static std::vector<const AotProgram*> registered;
+    return registered;
+}
+
+bool Aot::add(const AotProgram& program) {
+    programs().push_back(&program);
+    return true;
+}
+
+uint64_t Aot::pageHash(const Memory& memory, uint8_t page, uint16_t start, uint32_t size) {
+    uint32_t first = std::max<uint32_t>(page * PAGE_SIZE, start);
+    uint32_t end = std::min<uint32_t>((page + 1) * PAGE_SIZE, start + size);
+    uint8_t bytes[PAGE_SIZE];
+    for (uint32_t addr = first; addr < end; addr++)
+        bytes[addr - first] = memory.read(static_cast<uint16_t>(addr));
+    return fnv1a(bytes, first < end ? end - first : 0);
+}
+
+std::unique_ptr<Aot> Aot::attach(const Memory& memory) {
+    for (const AotProgram* program : programs()) {
+        auto aot = std::make_unique<Aot>(*program);
+        bool matches = true;
+        for (uint32_t page = program->start / PAGE_SIZE; page <= (program->start + program->size - 1) / PAGE_SIZE; page++)
+            matches &= aot->check(static_cast<uint8_t>(page), memory);
+        if (matches) return aot;
+    }
+    return nullptr;
+}
+
+Aot::Aot(const AotProgram& program) : program(program), blocks(program.size) {
+    for (size_t i = 0; i < program.blockCount; i++)
+        blocks[program.blocks[i].start - program.start] = &program.blocks[i];
+}
+
+// The page's counter moved: compare its bytes with the program's again
+bool Aot::check(uint8_t page, const Memory& memory) {
+    uint32_t index = page - program.start / PAGE_SIZE;
+    versions[page] = memory.pageVersion(page);
+    valid[page] = pageHash(memory, page, program.start, program.size) == program.pageHashes[index];
+    return valid[page];
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "memory.hpp"
+
+class Aot;
+class Intel8080;
+
+// One statically recompiled basic block
+struct AotBlock {
+    uint16_t start;                                 // Address of the first instruction
+    uint8_t  firstPage;                             // Memory pages the block's bytes span
+    uint8_t  lastPage;
+    void   (*code)(Intel8080* cpu, Aot& aot);
+};
+
+// A ROM image translated to C++ by Intel_8080_romcfg --cpp
+struct AotProgram {
+    const char*     name;                           // ROM the code was generated from
+    uint16_t        start;                          // Address the image is loaded at
+    uint32_t        size;
+    const uint64_t* pageHashes;                     // Aot::pageHash of every page the image covers
+    const AotBlock* blocks;                         // In address order
+    size_t          blockCount;
+};
+
+// Runs ahead-of-time recompiled code for a known ROM (Dispatch::Aot).
+//
+// The generated block functions run register moves, ALU ops and immediates
+// through Intel8080::opInline<OP> with the operand as a constant, and
+// everything else through the same per-opcode thunks as the JIT
+// (Intel8080::opThunk<OP>). They test the cycle budget after every
+// instruction and check the block's pages after every store, so they behave
+// exactly like the JIT's translations. Being ordinary C++ compiled with the
+// rest of the program, link-time optimisation inlines the handlers into
+// them, and nothing is generated or made executable at run time.
+//
+// Generated sources register their program at static initialisation. The
+// first Dispatch::Aot run looks for a program whose bytes are in memory;
+// from then on a page's bytes are compared with the program's page hash
+// whenever the page's write counter moves, so blocks on a reloaded, remapped
+// or patched page run only while the page still holds the original code.
+// Everything else (code reached through PCHL, code in RAM, invalid pages)
+// is interpreted by the block engine.
+class Aot {
+public:
+    using Code = void (*)(Intel8080* cpu, Aot& aot);
+
+    static bool add(const AotProgram& program);     // Registers a generated program, for static initialisers
+    static std::unique_ptr<Aot> attach(const Memory& memory);  // Runs the registered program found in memory, if any
+    static bool available()                         { return !programs().empty(); }
+    static uint64_t pageHash(const Memory& memory, uint8_t page, uint16_t start, uint32_t size);  // Of the page's bytes in [start, start + size)
+
+    explicit Aot(const AotProgram& program);
+
+    // Compiled code for the block at pc, if its pages still hold the program
+    Code find(uint16_t pc, const Memory& memory) {
+        if (static_cast<uint16_t>(pc - program.start) >= program.size) return nullptr;
+        const AotBlock* block = blocks[pc - program.start];
+        if (!block || !current(block->firstPage, block->lastPage, memory)) return nullptr;
+        return block->code;
+    }
+
+    // Called by block functions after a store
+    bool current(uint8_t firstPage, uint8_t lastPage, const Memory& memory) {
+        for (uint32_t page = firstPage; page <= lastPage; page++)
+            if (memory.pageVersion(page) != versions[page] ? !check(page, memory) : !valid[page]) return false;
+        return true;
+    }
+
+    const AotProgram& getProgram() const            { return program; }
+
+private:
+    const AotProgram&               program;
+    std::vector<const AotBlock*>    blocks;         // Indexed by pc - program.start
+    std::array<uint32_t, PAGES>     versions{};     // Page versions at the last check
+    std::array<bool, PAGES>         valid{};        // The page held the program's bytes then
+
+    static std::vector<const AotProgram*>& programs();
+    bool check(uint8_t page, const Memory& memory);
+};
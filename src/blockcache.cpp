@@ -0,0 +1,65 @@
+#include "blockcache.hpp"
+#include "instruction.hpp"
+
+BlockCache::BlockCache(const std::array<DecodedOp::Handler, 256>& handlers) : handlers(handlers), index(RAM_SIZE, NO_BLOCK) {}
+
+// Slow path of lookup(): decodes the block starting at pc, either because it
+// has never been seen or because its memory pages were written since.
+const Block& BlockCache::refill(uint16_t pc, const Memory& memory) {
+    int32_t i = index[pc];
+    if (i != NO_BLOCK) {
+        decode(blocks[i], pc, memory);
+        return blocks[i];
+    }
+
+    if (decoded.size() >= MAX_DECODED_OPS) clear();
+    index[pc] = static_cast<int32_t>(blocks.size());
+    blocks.emplace_back();
+    decode(blocks.back(), pc, memory);
+    return blocks.back();
+}
+
+void BlockCache::clear() {
+    std::fill(index.begin(), index.end(), NO_BLOCK);
+    blocks.clear();
+    decoded.clear();
+}
+
+// Decodes a straight-line run starting at pc. Re-decoded blocks append fresh
+// ops; the stale ones are reclaimed when the cache is flushed.
+void BlockCache::decode(Block& block, uint16_t pc, const Memory& memory) {
+    block.start = pc;
+    block.first = static_cast<uint32_t>(decoded.size());
+    block.count = 0;
+    block.maxCycles = 0;
+
+    uint16_t addr = pc;
+    uint16_t last = pc;
+    for (int n = 0; n < MAX_BLOCK_OPS; n++) {
+        DecodedOp op{};
+        op.pc = addr;
+        op.opcode = memory.read(addr);
+        const OpcodeInfo& info = OPCODES[op.opcode];
+        op.handler = handlers[op.opcode];
+        op.regs[0] = info.values[0];
+        op.regs[1] = info.values[1];
+        op.cycles = info.cyclesNotTaken;
+        op.writesMemory = info.flags & OpcodeInfo::WRITES_MEMORY;
+        if (info.length > 1) op.imm = memory.read(addr + 1);
+        if (info.length > 2) op.imm |= (uint16_t) memory.read(addr + 2) << 8;
+
+        decoded.push_back(op);
+        block.count++;
+        block.maxCycles += info.cycles;
+        last = addr + info.length - 1;
+        addr += info.length;
+
+        // Stop at branches, and never wrap around the address space
+        if (info.endsBlock() || addr < pc) break;
+    }
+
+    block.firstPage = pc >> 8;
+    block.lastPage = last >= pc ? last >> 8 : 0xFF;
+    block.versions[0] = memory.pageVersion(block.firstPage);
+    block.versions[1] = memory.pageVersion(block.lastPage);
+}
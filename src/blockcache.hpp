@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "memory.hpp"
+
+class Intel8080;
+
+// A single pre-decoded instruction: the handler that runs it and everything
+// the handler needs, read from the instruction bytes and OPCODES once.
+struct DecodedOp {
+    using Handler = void (*)(Intel8080* cpu, const DecodedOp& op);
+
+    Handler  handler;       // Runs this instruction from the fields below (Intel8080::opDecoded)
+    uint16_t pc;            // Address of the opcode
+    uint16_t imm;           // Immediate, address or jump target (little endian), 0 if none
+    uint8_t  opcode;        // Instruction byte
+    uint8_t  regs[2];       // Register, pair or RST number of each operand (OpcodeInfo::values)
+    uint8_t  cycles;        // Cycle cost, the not-taken one for conditional calls and returns
+    bool     writesMemory;  // The instruction may store to memory (MOV M, STA, PUSH, ...)
+};
+
+// A straight-line run of instructions ending at a branch, HLT, or MAX_BLOCK_OPS.
+// The ops live in BlockCache::ops[first, first + count).
+struct Block {
+    uint16_t start;         // Address of the first instruction
+    uint16_t count;         // Number of decoded instructions
+    uint32_t first;         // Index of the first op in BlockCache::ops
+    uint32_t maxCycles;     // Sum of worst-case cycle costs of all ops
+    uint8_t  firstPage;     // Memory pages the block's bytes span (at most two)
+    uint8_t  lastPage;
+    uint32_t versions[2];   // Memory::pageVersion of firstPage/lastPage when decoded
+};
+
+// Decoded-block cache keyed by the block's start address. Blocks are
+// validated against Memory's per-page write counters on lookup, so any write
+// into a page holding decoded code (self-modifying code, loading a new program)
+// makes the block re-decode the next time it is entered.
+class BlockCache {
+public:
+    static constexpr int MAX_BLOCK_OPS = 32;   // Keeps a block within two 256-byte pages
+
+    explicit BlockCache(const std::array<DecodedOp::Handler, 256>& handlers);
+
+    // Find or decode the block starting at pc
+    const Block&     lookup(uint16_t pc, const Memory& memory) {
+        int32_t i = index[pc];
+        if (i != NO_BLOCK && !isStale(blocks[i], memory)) return blocks[i];
+        return refill(pc, memory);
+    }
+    const DecodedOp* ops(const Block& block) const                  { return &decoded[block.first]; }
+    bool             isStale(const Block& block, const Memory& memory) const {
+        return memory.pageVersion(block.firstPage) != block.versions[0] ||
+               memory.pageVersion(block.lastPage)  != block.versions[1];
+    }
+    void             clear();
+
+private:
+    static constexpr uint32_t MAX_DECODED_OPS = 1 << 18;            // Flush everything beyond this many ops
+    static constexpr int32_t  NO_BLOCK = -1;
+
+    const std::array<DecodedOp::Handler, 256>& handlers;   // Indexed by opcode
+    std::vector<int32_t>   index;       // Block index for each of the 64K addresses, or NO_BLOCK
+    std::vector<Block>     blocks;
+    std::vector<DecodedOp> decoded;
+
+    const Block& refill(uint16_t pc, const Memory& memory);
+    void decode(Block& block, uint16_t pc, const Memory& memory);
+};
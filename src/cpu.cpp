@@ -1,51 +1,145 @@
 #include "cpu.hpp"
+#include "aot.hpp"
+#include "blockcache.hpp"
+#include "jit.hpp"
+#include "instruction.hpp"
 
-Intel8080::Intel8080() : intEnable(), pc(), sp(), reg8(), memory(nullptr), ioPorts(nullptr){
-    memory = new Memory();
-    ioPorts = new IOPorts();
+#ifdef I8080_SWITCH_DISPATCH
+constexpr Intel8080::Dispatch DEFAULT_DISPATCH = Intel8080::Dispatch::Switch;
+#else
+constexpr Intel8080::Dispatch DEFAULT_DISPATCH = Intel8080::Dispatch::Table;
+#endif
 
+Intel8080::Intel8080() : memory(std::make_unique<Memory>()), ioPorts(std::make_unique<IOPorts>()),
+                         sp(), pc(), intEnable(), cycles(), cycleEnd(), dispatch(DEFAULT_DISPATCH),
+                         zspResult(), zspLazy(), reg8() {
+    // Handlers in Mnemonic order; undocumented aliases trap in XXX
     using a = Intel8080;
-    lookup = {
-            &a::NOP,  &a::LXI, &a::STAX, &a::INX,  &a::INR,  &a::DCR,  &a::MVI, &a::RLC, &a::XXX,  &a::DAD,  &a::LDAX, &a::DCX, &a::INR,  &a::DCR,  &a::MVI, &a::RRC,
-            &a::XXX,  &a::LXI, &a::STAX, &a::INX,  &a::INR,  &a::DCR,  &a::MVI, &a::RAL, &a::XXX,  &a::DAD,  &a::LDAX, &a::DCX, &a::INR,  &a::DCR,  &a::MVI, &a::RAR,
-            &a::XXX,  &a::LXI, &a::SHLD, &a::INX,  &a::INR,  &a::DCR,  &a::MVI, &a::DAA, &a::XXX,  &a::DAD,  &a::LHLD, &a::DCX, &a::INR,  &a::DCR,  &a::MVI, &a::CMA,
-            &a::XXX,  &a::LXI, &a::STA,  &a::INX,  &a::INR,  &a::DCR,  &a::MVI, &a::STC, &a::XXX,  &a::DAD,  &a::LDA,  &a::DCX, &a::INR,  &a::DCR,  &a::MVI, &a::CMC,
-            &a::MOV,  &a::MOV, &a::MOV,  &a::MOV,  &a::MOV,  &a::MOV,  &a::MOV, &a::MOV, &a::MOV,  &a::MOV,  &a::MOV,  &a::MOV, &a::MOV,  &a::MOV,  &a::MOV, &a::MOV,
-            &a::MOV,  &a::MOV, &a::MOV,  &a::MOV,  &a::MOV,  &a::MOV,  &a::MOV, &a::MOV, &a::MOV,  &a::MOV,  &a::MOV,  &a::MOV, &a::MOV,  &a::MOV,  &a::MOV, &a::MOV,
-            &a::MOV,  &a::MOV, &a::MOV,  &a::MOV,  &a::MOV,  &a::MOV,  &a::MOV, &a::MOV, &a::MOV,  &a::MOV,  &a::MOV,  &a::MOV, &a::MOV,  &a::MOV,  &a::MOV, &a::MOV,
-            &a::MOV,  &a::MOV, &a::MOV,  &a::MOV,  &a::MOV,  &a::MOV,  &a::HLT, &a::MOV, &a::MOV,  &a::MOV,  &a::MOV,  &a::MOV, &a::MOV,  &a::MOV,  &a::MOV, &a::MOV,
-            &a::ADD,  &a::ADD, &a::ADD,  &a::ADD,  &a::ADD,  &a::ADD,  &a::ADD, &a::ADD, &a::ADC,  &a::ADC,  &a::ADC,  &a::ADC, &a::ADC,  &a::ADC,  &a::ADC, &a::ADC,
-            &a::SUB,  &a::SUB, &a::SUB,  &a::SUB,  &a::SUB,  &a::SUB,  &a::SUB, &a::SUB, &a::SBB,  &a::SBB,  &a::SBB,  &a::SBB, &a::SBB,  &a::SBB,  &a::SBB, &a::SBB,
-            &a::ANA,  &a::ANA, &a::ANA,  &a::ANA,  &a::ANA,  &a::ANA,  &a::ANA, &a::ANA, &a::XRA,  &a::XRA,  &a::XRA,  &a::XRA, &a::XRA,  &a::XRA,  &a::XRA, &a::XRA,
-            &a::ORA,  &a::ORA, &a::ORA,  &a::ORA,  &a::ORA,  &a::ORA,  &a::ORA, &a::ORA, &a::CMP,  &a::CMP,  &a::CMP,  &a::CMP, &a::CMP,  &a::CMP,  &a::CMP, &a::CMP,
-            &a::Rccc, &a::POP, &a::Jccc, &a::JMP,  &a::Cccc, &a::PUSH, &a::ADI, &a::RST, &a::Rccc, &a::RET,  &a::Jccc, &a::XXX, &a::Cccc, &a::CALL, &a::ACI, &a::RST,
-            &a::Rccc, &a::POP, &a::Jccc, &a::OUT,  &a::Cccc, &a::PUSH, &a::SUI, &a::RST, &a::Rccc, &a::XXX,  &a::Jccc, &a::IN,  &a::Cccc, &a::XXX,  &a::SBI, &a::RST,
-            &a::Rccc, &a::POP, &a::Jccc, &a::XTHL, &a::Cccc, &a::PUSH, &a::ANI, &a::RST, &a::Rccc, &a::PCHL, &a::Jccc, &a::XCHG,&a::Cccc, &a::XXX,  &a::XRI, &a::RST,
-            &a::Rccc, &a::POP, &a::Jccc, &a::DI,   &a::Cccc, &a::PUSH, &a::ORI, &a::RST, &a::Rccc, &a::SPHL, &a::Jccc, &a::EI,  &a::Cccc, &a::XXX,  &a::CPI, &a::RST
+    static constexpr Operation handlers[MNEMONIC_COUNT] = {
+            &a::ACI,  &a::ADC,  &a::ADD,  &a::ADI,  &a::ANA,  &a::ANI,  &a::CALL, &a::Cccc, &a::CMA,  &a::CMC,
+            &a::CMP,  &a::CPI,  &a::DAA,  &a::DAD,  &a::DCR,  &a::DCX,  &a::DI,   &a::EI,   &a::HLT,  &a::IN,
+            &a::INR,  &a::INX,  &a::Jccc, &a::JMP,  &a::LDA,  &a::LDAX, &a::LHLD, &a::LXI,  &a::MOV,  &a::MVI,
+            &a::NOP,  &a::ORA,  &a::ORI,  &a::OUT,  &a::PCHL, &a::POP,  &a::PUSH, &a::RAL,  &a::RAR,  &a::Rccc,
+            &a::RET,  &a::RLC,  &a::RRC,  &a::RST,  &a::SBB,  &a::SBI,  &a::SHLD, &a::SPHL, &a::STA,  &a::STAX,
+            &a::STC,  &a::SUB,  &a::SUI,  &a::XCHG, &a::XRA,  &a::XRI,  &a::XTHL
     };
+    lookup.resize(OPCODES.size());
+    for (size_t op = 0; op < OPCODES.size(); op++)
+        lookup[op] = OPCODES[op].flags & OpcodeInfo::UNDOCUMENTED ? &a::XXX
+                                                                 : handlers[static_cast<size_t>(OPCODES[op].mnemonic)];
 }
 
+// Defined here, where the execution tiers are complete types
+Intel8080::~Intel8080() = default;
+
 // Executes a specified number of CPU cycles
 int Intel8080::execute(int numCycles) {
+    NullTrace trace;
+    return execute(numCycles, trace);
+}
+
+// Executes a specified number of CPU cycles, handing every instruction to
+// the trace sink before it runs. With NullTrace the record is never built.
+template <typename Trace>
+int Intel8080::execute(int numCycles, Trace& trace) {
+    // Keep cycleCount() continuous: the overshoot left in `cycles` by the
+    // last call is already counted
+    cycleEnd += numCycles - cycles;
+
+    // Whatever ran in between (interrupts, events) may have changed memory
+    skipping = idleSkip && !Trace::enabled;
+    idle.active = false;
+
+    if (dispatch == Dispatch::Switch)
+        return executeSwitch(numCycles, trace);
+    if (dispatch == Dispatch::Block)
+        return executeBlocks(numCycles, trace);
+    if (dispatch == Dispatch::Jit)
+        return executeJit(numCycles, trace);
+    if (dispatch == Dispatch::Aot)
+        return executeAot(numCycles, trace);
+
     cycles = numCycles;
 
     while (cycles > 0) {
         opcode = read(pc++);
-        disassemble(opcode, pc - 1);
+        if constexpr (Trace::enabled)
+            trace.record(*this, traceRecord());
+        charge();
         (this->*lookup[opcode])();
     }
 
     return cycles;
 }
 
-// Reads a byte from memory at the specified address
-uint8_t Intel8080::read(uint16_t addr) const {
-    return memory->read(addr);
+template int Intel8080::execute<NullTrace>(int, NullTrace&);
+template int Intel8080::execute<CountTrace>(int, CountTrace&);
+template int Intel8080::execute<RingTrace>(int, RingTrace&);
+template int Intel8080::execute<TextFileTrace>(int, TextFileTrace&);
+template int Intel8080::execute<BinaryFileTrace>(int, BinaryFileTrace&);
+
+// Instructions an idle loop may contain: nothing that stores to memory,
+// does I/O, changes interrupts or leaves the loop. Jumps are checked
+// separately.
+static bool isIdleSafe(const OpcodeInfo& info) {
+    constexpr uint8_t unsafe = OpcodeInfo::JUMP | OpcodeInfo::CALL | OpcodeInfo::RETURN | OpcodeInfo::WRITES_MEMORY |
+                               OpcodeInfo::HALTS | OpcodeInfo::UNDOCUMENTED;
+    switch (info.mnemonic) {
+        case Mnemonic::IN: case Mnemonic::OUT: case Mnemonic::EI: case Mnemonic::DI:
+            return false;
+        default:
+            return !(info.flags & unsafe);
+    }
+}
+
+// The loop from `head` to the jump at `branch` only reads: every instruction
+// is idle-safe, and every jump in it lands inside it. Then it can only be
+// left by falling through `branch`, which idleExit() notices.
+bool Intel8080::isPureLoop(uint16_t head, uint16_t branch) const {
+    uint32_t addr = head;
+    while (addr < branch) {
+        const OpcodeInfo& info = OPCODES[read(addr)];
+        if (info.mnemonic == Mnemonic::JMP || info.mnemonic == Mnemonic::Jccc) {
+            uint16_t target = read16(addr + 1);
+            if ((info.flags & OpcodeInfo::UNDOCUMENTED) || target < head || target > branch) return false;
+        } else if (!isIdleSafe(info)) {
+            return false;
+        }
+        addr += info.length;
+    }
+    return addr == branch && !memory->hasReadHandlers();
 }
 
-// Writes a byte to memory at the specified address
-void Intel8080::write(uint16_t addr, uint8_t data) const {
-    memory->write(addr, data);
+// Called on a taken backward jump from `branch` to `head`, after its cycles
+// are counted. Once the loop has come round with the same registers, every
+// further iteration takes as many cycles as the last one; skip all but the
+// one that runs out the budget, which then runs normally.
+void Intel8080::idleLoop(uint16_t head, uint16_t branch) {
+    std::array<uint8_t, 9> state = reg8;
+    state[M] = 0;
+    state[FLAGS] = flags();
+
+    if (idle.active && idle.head == head && idle.branch == branch && idle.reg8 == state && idle.sp == sp) {
+        if (!idle.checked) {
+            idle.pure = isPureLoop(head, branch);
+            idle.checked = true;
+        }
+        int iteration = idle.cycles - cycles;
+        if (idle.pure && iteration > 0 && cycles > iteration) {
+            int repeats = (cycles - 1) / iteration;
+            cycles -= repeats * iteration;
+            idleSkipped += (uint64_t) repeats * iteration;
+        }
+    } else if (!idle.active || idle.head != head || idle.branch != branch) {
+        idle.checked = false;
+    }
+
+    idle.active = true;
+    idle.head = head;
+    idle.branch = branch;
+    idle.reg8 = state;
+    idle.sp = sp;
+    idle.cycles = cycles;
 }
 
 // Reads from an input port
@@ -54,7 +148,7 @@ uint8_t Intel8080::inport(uint8_t port) const {
 }
 // Writes to an output port
 void Intel8080::outport(uint8_t port, uint8_t data) const {
-    ioPorts->write(port, data);
+    ioPorts->write(port, data, cycleCount());
 }
 
 // Triggers an interrupt with the given interrupt number
@@ -65,6 +159,26 @@ void Intel8080::interrupt(uint8_t n) {
     intEnable = 0;
 }
 
+void Intel8080::saveState(CpuState& state) const {
+    state.reg8 = reg8;
+    state.reg8[FLAGS] = flags();
+    state.sp = sp;
+    state.pc = pc;
+    state.intEnable = intEnable;
+    state.cycles = cycles;
+    state.cycleEnd = cycleEnd;
+}
+
+void Intel8080::loadState(const CpuState& state) {
+    reg8 = state.reg8;
+    zspLazy = false;    // the saved flags are already complete
+    sp = state.sp;
+    pc = state.pc;
+    intEnable = state.intEnable;
+    cycles = state.cycles;
+    cycleEnd = state.cycleEnd;
+}
+
 // Loads a game or program from a file into memory
 bool Intel8080::load(const std::string& filePath, uint16_t loadAddress) const {
     return memory->load(filePath, loadAddress);
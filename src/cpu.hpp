@@ -1,28 +1,100 @@
 #pragma once
 
+#include <array>
 #include <cstdint> // for uint8_t and uint16_t types
+#include <cstdio>
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "memory.hpp"
+#include "instruction.hpp"
 #include "io.hpp"
+#include "trace.hpp"
+
+// Execution tiers, created on first use; only opcodes.cpp needs their definitions
+class Aot;
+struct Block;
+class BlockCache;
+struct DecodedOp;
+class Jit;
+
+// Zero (bit 6), Sign (bit 7) and Parity (bit 2) flag bits for every 8-bit result.
+// Parity is set when there is an even number of 1 bits.
+// See approach 2 in editorial: https://leetcode.com/problems/number-of-1-bits/editorial/
+constexpr std::array<uint8_t, 256> ZSP_TABLE = [] {
+    std::array<uint8_t, 256> table{};
+    for (int value = 0; value < 256; value++) {
+        uint8_t oneBitsCount = 0;
+        for (uint8_t bits = value; bits != 0; oneBitsCount++)
+            bits &= (bits - 1);
+        table[value] = (value & 0x80) | (value == 0 ? 0x40 : 0) | ((oneBitsCount & 1) == 0 ? 0x04 : 0);
+    }
+    return table;
+}();
+
+// Architectural state of the CPU, as saved in snapshots (see Machine::save)
+struct CpuState {
+    std::array<uint8_t, 9> reg8;    // B, C, D, E, H, L, M, A, FLAGS (flags fully evaluated)
+    uint16_t sp;
+    uint16_t pc;
+    uint8_t  intEnable;
+    int32_t  cycles;                // Overshoot left by the last execute()
+    uint64_t cycleEnd;              // cycleCount() = cycleEnd - cycles
+};
 
 class Intel8080 {
 public:
+    // Instruction dispatch strategies. Table goes through the `lookup` vector of
+    // member-function pointers; Switch uses a switch with the handlers inlined;
+    // Block runs pre-decoded basic blocks from a BlockCache;
+    // Jit additionally translates hot blocks to native code (see jit.hpp) and
+    // behaves like Block where the JIT is unavailable or a trace sink is attached;
+    // Aot runs code recompiled from a known ROM at build time (see aot.hpp) and
+    // likewise behaves like Block for everything else.
+    enum class Dispatch : uint8_t { Table, Switch, Block, Jit, Aot };
+
     Intel8080();
+    ~Intel8080();
 
     int     execute(int numCycles);                                         // Execute cycles
-    uint8_t read(uint16_t addr) const;                                      // Read memory
-    void    write(uint16_t addr, uint8_t data) const;                       // Write memory
+    template <typename Trace>
+    int     execute(int numCycles, Trace& trace);                           // Execute cycles, reporting each instruction to a trace sink
+    uint8_t read(uint16_t addr) const           { return memory->read(addr); }          // Read memory
+    void    write(uint16_t addr, uint8_t data) const { memory->write(addr, data); }     // Write memory
     uint8_t inport(uint8_t port) const;                                     // Read input port
     void    outport(uint8_t port, uint8_t data) const;                      // Write output port
     void    interrupt(uint8_t n);                                           // Raise interrupt
-    int     disassemble(uint8_t opcode, uint16_t pc);                       // Translate hex code to assembly
+    int     disassemble(uint8_t opcode, uint16_t pc, FILE* out = stdout) const; // Translate hex code to assembly
+    static int disassemble(uint8_t opcode, const uint8_t operands[2], uint16_t pc, FILE* out);  // Same, operand bytes given
     bool    load(const std::string& filePath, uint16_t loadAddress) const;  // Load program into memory
+    void    setDispatch(Dispatch d)     { dispatch = d; }                   // Select the execution engine
+    Dispatch getDispatch() const        { return dispatch; }
+    uint64_t cycleCount() const         { return cycleEnd - cycles; }     // Cycles executed since power-on, exact mid-instruction too
+    void    setIdleSkip(bool enabled)   { idleSkip = enabled; }             // Fast-forward HLT and idle loops (default on)
+    uint64_t idleCycles() const         { return idleSkipped; }             // Cycles fast-forwarded so far
+    void    saveState(CpuState& state) const;                               // Copy out registers and timing
+    void    loadState(const CpuState& state);                               // Resume from a saved state
+
+    // Compiled-code entry point (see jit.hpp, aot.hpp): runs opcode OP with pc
+    // preset to the byte after it, returns the remaining cycles
+    using Thunk = int (*)(Intel8080* cpu, uint32_t pc);
+    template <uint8_t OP>
+    static int opThunk(Intel8080* cpu, uint32_t pc);
 
-    Memory*     memory;     // Pointer to memory management object
-    IOPorts*    ioPorts;    // Pointer to IO port management object
+    // Opcodes simple enough for compiled code to run without a thunk: register
+    // moves and ALU ops (not M), immediates, and register pair arithmetic
+    static constexpr bool inlinable(uint8_t op);
+    // Runs inlinable opcode OP with its operand `imm` known in advance, then
+    // sets pc to `next`, the address of the following instruction; returns the
+    // remaining cycles. Defined in opinline.hpp so it inlines into its callers.
+    template <uint8_t OP>
+    static int opInline(Intel8080* cpu, uint32_t next, uint16_t imm);
+
+    std::unique_ptr<Memory>  memory;    // Memory management object, owned by this CPU
+    std::unique_ptr<IOPorts> ioPorts;   // IO port management object, owned by this CPU
 
 private:
     uint16_t sp;            // Stack pointer
@@ -30,6 +102,10 @@ private:
     uint8_t  opcode;        // Current instruction
     uint8_t  intEnable;     // Interrupt enable/disable flag
     int      cycles;        // Clock cycle counter for accurate emulation
+    uint64_t cycleEnd;      // Cycle count at which the current budget runs out; see cycleCount()
+    Dispatch dispatch;      // Execution engine used by execute()
+    uint8_t  zspResult;     // Last result the Zero, Sign and Parity flags derive from
+    bool     zspLazy;       // Z, S and P in reg8[FLAGS] are stale and must be taken from zspResult
 
     // Enumerations for register and flag identifiers.
     // Dest and Source reg fields:
@@ -58,6 +134,67 @@ private:
     typedef void (Intel8080::*Operation)();
     std::vector<Operation> lookup;
 
+    // Alternative execution engines, defined next to the handlers in opcodes.cpp
+    template <typename Trace>
+    int executeSwitch(int numCycles, Trace& trace);
+    template <typename Trace>
+    int executeBlocks(int numCycles, Trace& trace);
+    template <typename Trace>
+    int executeJit(int numCycles, Trace& trace);
+    template <typename Trace>
+    int executeAot(int numCycles, Trace& trace);
+    template <typename Trace>
+    inline void runBlock(const Block& block, Trace& trace);    // Interpret one decoded block
+    inline void step();                                         // Run the handler for `opcode`
+
+    // JIT entry points: opThunk for every opcode, indexed by opcode
+    static const std::array<Thunk, 256>& opThunks();
+
+    // Block engine handlers: run opcode OP from a DecodedOp, taking the operands
+    // and cost from it instead of memory, and leave pc at the next instruction
+    // or the branch target. opDecodedHandlers() indexes them by opcode.
+    template <uint8_t OP>
+    static void opDecoded(Intel8080* cpu, const DecodedOp& op);
+    static const std::array<void (*)(Intel8080*, const DecodedOp&), 256>& opDecodedHandlers();
+
+    // Idle skipping. Interrupts only arrive between execute() calls, so a
+    // halted CPU just burns its budget, and so does a short backward loop
+    // that stores nothing and comes back to its head with the same registers
+    // (a wait for the interrupt handler to change some RAM flag): every
+    // further iteration repeats the last one exactly. Both are fast-forwarded
+    // to the same instruction boundary and cycle count as running them, so
+    // results do not change. Traced runs see every instruction.
+    static constexpr uint16_t IDLE_LOOP_BYTES = 16;        // Longest loop considered
+    struct IdleLoop {
+        bool     active;                    // A loop is being watched
+        bool     checked;                   // Its body has been scanned...
+        bool     pure;                      // ...and found free of stores, I/O and exits
+        uint16_t head;                      // Loop start, the backward jump's target
+        uint16_t branch;                    // Address of the backward jump
+        std::array<uint8_t, 9> reg8;        // Registers (flags evaluated) and SP at the last arrival
+        uint16_t sp;
+        int      cycles;                    // `cycles` at the last arrival
+    };
+    bool     idleSkip = true;
+    bool     skipping = false;              // idleSkip, and the current execute() is untraced
+    IdleLoop idle{};
+    uint64_t idleSkipped = 0;
+
+    void    idleLoop(uint16_t head, uint16_t branch);   // A backward jump closing a short loop was taken
+    void    idleExit(uint16_t branch)       { if (branch == idle.branch) idle.active = false; }
+    bool    isPureLoop(uint16_t head, uint16_t branch) const;
+
+    std::unique_ptr<BlockCache> blockCache; // Created on first use by the Block, Jit and Aot engines
+    std::unique_ptr<Jit>        jit;        // Created on first use by the Jit engine
+    std::unique_ptr<Aot>        aot;        // Looked up on first use by the Aot engine, null if no program matches
+    bool                        aotAttached = false;
+
+    // Builds the trace record for the instruction just fetched
+    TraceRecord traceRecord() const {
+        return { cycleCount(), static_cast<uint16_t>(pc - 1), sp, opcode, { read(pc), read(pc + 1) },
+                 { reg8[B], reg8[C], reg8[D], reg8[E], reg8[H], reg8[L], reg8[A], flags() }, 0 };
+    }
+
 private:
     // List of all unique 8080 opcodes in alphabetical order
     void  ACI();        void   IN();        void  RAR();
@@ -84,11 +221,15 @@ private:
     void  XXX();
 
 private:
-    // Methods to access and manipulate register values and stack operations
-    uint8_t     readReg8(uint8_t r);
-    void        writeReg8(uint8_t r, uint8_t value);
-    void        push(uint16_t value);
-    uint16_t    pop();
+    // Methods to access and manipulate register values and stack operations.
+    // The memory ones are defined here so that every handler inlines them.
+    uint8_t     readReg8(uint8_t r)                 { return r == M ? read(reg16_HL()) : reg8[r]; }
+    void        writeReg8(uint8_t r, uint8_t value) { if (r == M) write(reg16_HL(), value); else reg8[r] = value; }
+    uint16_t    read16(uint16_t addr) const         { return memory->read16(addr); }    // Little-endian word
+    void        write16(uint16_t addr, uint16_t value) const { memory->write16(addr, value); }
+    uint16_t    fetch16() const                     { return read16(pc); }              // 16-bit operand at pc (a16/d16)
+    void        push(uint16_t value)                { sp -= 2; write16(sp, value); }
+    uint16_t    pop()                               { sp += 2; return read16(sp - 2); }
     uint16_t    readRP(uint8_t rp);
     void        writeRP(uint8_t rp, uint8_t lb, uint8_t hb);
     void        write16RP(uint8_t rp, uint16_t value);
@@ -99,14 +240,107 @@ private:
     uint16_t reg16_BC() const   { return (((uint16_t) reg8[B]) << 8) | (uint16_t) reg8[C]; }
     uint16_t reg16_DE() const   { return (((uint16_t) reg8[D]) << 8) | (uint16_t) reg8[E]; }
     uint16_t reg16_HL() const   { return (((uint16_t) reg8[H]) << 8) | (uint16_t) reg8[L]; }
-    uint16_t reg16_PSW() const  { return (((uint16_t) reg8[A]) << 8) | (uint16_t) reg8[FLAGS]; }
+    uint16_t reg16_PSW() const  { return (((uint16_t) reg8[A]) << 8) | (uint16_t) flags(); }
 
-    // Helper methods for setting/getting/testing condition flags
-    uint8_t GetFlag(FLAGS8080 f);
+    // Helper methods for setting/getting/testing condition flags.
+    // Z, S and P are evaluated lazily: SetZSP only remembers the result, and the
+    // bits are looked up in ZSP_TABLE when something actually reads them
+    // (conditional branches, PUSH PSW, tracing). AC and CY are stored directly.
+    static constexpr uint8_t ZSP_MASK = (1 << S) | (1 << Z) | (1 << P);
+    uint8_t flags() const               { return zspLazy ? (reg8[FLAGS] & ~ZSP_MASK) | ZSP_TABLE[zspResult] : reg8[FLAGS]; }
+    uint8_t GetFlag(FLAGS8080 f) const  { return ((f == CY || f == AC ? reg8[FLAGS] : flags()) >> f) & 1; }
+    void    SetFlag(FLAGS8080 f, bool v) { reg8[FLAGS] = (reg8[FLAGS] & ~(1 << f)) | ((uint8_t) v << f); }
+    void    SetZSP(uint8_t value)       { zspResult = value; zspLazy = true; }
     bool    TestCond(uint8_t code);
-    void    SetFlag(FLAGS8080 f, bool v);
-    void    SetZSP(uint8_t value);
-    bool    parity(uint8_t value);
-    bool    carry(uint8_t a, uint8_t b, uint8_t result, uint8_t mask);
-    bool    borrow(uint8_t a, uint8_t b, uint8_t result, uint8_t mask);
-};
\ No newline at end of file
+
+    // Checks if an addition operation resulted in a carry.
+    //
+    // Basically the flag is testing the result of upper bits:
+    // Carry can occur in one of three cases:
+    // 1. msb(a) and msb(b) are set (0.1xxx + 0.1xxx -> 1.0xxx)
+    // 2. msb(a) is set but msb(result) is not set (0.1xxx + 0.xxxx -> 1.0xxx)
+    // 3. msb(b) is set but msb(result) is not set (0.xxxx + 0.1xxx -> 1.0xxx)
+    // Source: https://www.reddit.com/r/EmuDev/comments/110epqk/comment/j89y04a/?utm_source=share&utm_medium=web2x&context=3
+    bool    carry(uint8_t a, uint8_t b, uint8_t result, uint8_t mask) { return ((a & b) | (a & ~result) | (b & ~result)) & mask; }
+    // Checks if a subtraction operation resulted in a borrow.
+    // a - b = result => a = b + result
+    bool    borrow(uint8_t a, uint8_t b, uint8_t result, uint8_t mask) { return carry(result, b, a, mask); }
+
+    // Arithmetic and logic on the accumulator, shared by the register, memory
+    // and immediate forms of each instruction and by opInline
+    void aluAdd(uint8_t value, uint8_t carryIn) {
+        uint16_t result = reg8[A] + value + carryIn;
+        SetFlag(AC, carry(reg8[A], value + carryIn, result, 0x08));
+        SetFlag(CY, result & 0xFF00);
+        SetZSP(static_cast<uint8_t>(result));
+        reg8[A] = result & 0xFF;
+    }
+    void aluSub(uint8_t value, uint8_t borrowIn) {
+        uint16_t result = reg8[A] - value - borrowIn;
+        SetFlag(AC, borrow(reg8[A], value + borrowIn, result, 0x08));
+        SetFlag(CY, borrow(reg8[A], value + borrowIn, result, 0x80));
+        SetZSP(static_cast<uint8_t>(result));
+        reg8[A] = result & 0xFF;
+    }
+    void aluCmp(uint8_t value) {
+        SetFlag(CY, reg8[A] < value);
+        SetFlag(AC, (reg8[A] & 0x0F) < (value & 0x0F));
+        SetZSP(static_cast<uint8_t>(reg8[A] - value));
+    }
+    void aluAnd(uint8_t value) {
+        SetFlag(AC, (reg8[A] | value) & 0x80);
+        SetFlag(CY, false);
+        reg8[A] &= value;
+        SetZSP(reg8[A]);
+    }
+    void aluXor(uint8_t value) {
+        reg8[A] ^= value;
+        SetFlag(AC, false);
+        SetFlag(CY, false);
+        SetZSP(reg8[A]);
+    }
+    void aluOr(uint8_t value) {
+        reg8[A] |= value;
+        SetFlag(AC, false);
+        SetFlag(CY, false);
+        SetZSP(reg8[A]);
+    }
+    uint8_t aluInr(uint8_t value) {
+        SetFlag(AC, carry(value, 1, value + 1, 0x08));
+        SetZSP(value + 1);
+        return value + 1;
+    }
+    uint8_t aluDcr(uint8_t value) {
+        SetFlag(AC, (value & 0x0F) == 0);
+        SetZSP(value - 1);
+        return value - 1;
+    }
+
+    // Cycle costs come from OPCODES: every engine charges the opcode's cost
+    // before its handler runs, the not-taken cost for conditional calls and
+    // returns, which add the difference when they branch
+    void    charge()                    { cycles -= OPCODES[opcode].cyclesNotTaken; }
+    void    chargeTaken()               { cycles -= OPCODES[opcode].cycles - OPCODES[opcode].cyclesNotTaken; }
+};
+
+constexpr bool Intel8080::inlinable(uint8_t op) {
+    const OpcodeInfo& info = OPCODES[op];
+    if (info.flags & OpcodeInfo::UNDOCUMENTED) return false;
+    bool memory = false;
+    for (int i = 0; i < 2; i++)
+        memory |= info.operands[i] == Operand::Reg && info.values[i] == M;
+
+    switch (info.mnemonic) {
+        case Mnemonic::MOV: case Mnemonic::MVI: case Mnemonic::INR: case Mnemonic::DCR:
+        case Mnemonic::ADD: case Mnemonic::ADC: case Mnemonic::SUB: case Mnemonic::SBB:
+        case Mnemonic::ANA: case Mnemonic::XRA: case Mnemonic::ORA: case Mnemonic::CMP:
+            return !memory;
+        case Mnemonic::ADI: case Mnemonic::ACI: case Mnemonic::SUI: case Mnemonic::SBI:
+        case Mnemonic::ANI: case Mnemonic::XRI: case Mnemonic::ORI: case Mnemonic::CPI:
+        case Mnemonic::LXI: case Mnemonic::INX: case Mnemonic::DCX: case Mnemonic::NOP:
+        case Mnemonic::CMA: case Mnemonic::CMC: case Mnemonic::STC: case Mnemonic::XCHG:
+            return true;
+        default:
+            return false;
+    }
+}
@@ -1,13 +1,11 @@
 #include "display.hpp"
+#include "allocations.hpp"
 
-constexpr uint16_t SCREEN_WIDTH = 224;
-constexpr uint16_t SCREEN_HEIGHT = 256;
-constexpr uint16_t MEMORY_BASE_OFFSET = 0x2400;
-constexpr uint16_t VERTICAL_OFFSET_MULTIPLIER = 0x20;
-
-Display::Display() : window(sf::VideoMode(1.5 * SCREEN_WIDTH, 1.5 * SCREEN_HEIGHT), "Space Invaders") {
-    window.setFramerateLimit(60);
+Display::Display() : window(sf::VideoMode(1.5 * SCREEN_WIDTH, 1.5 * SCREEN_HEIGHT), "Space Invaders"),
+                     overlay(), pixels(),
+                     stripVersions(), firstFrame(true) {
     texture.create(SCREEN_WIDTH, SCREEN_HEIGHT);
+    sprite.setTexture(texture);
 
     // Create and set the view to scale the original content.
     // This is done so that the window isn't too small upon initial display.
@@ -22,43 +20,52 @@ Display::Display() : window(sf::VideoMode(1.5 * SCREEN_WIDTH, 1.5 * SCREEN_HEIGH
         exit(1);
     }
     backgroundSprite.setTexture(backgroundTexture);
-}
 
-void Display::draw(Intel8080& cpu) {
-    // Initialize a 224x256 image (rotated anticlockwise) filled with black color
-    sf::Image image;
-    image.create(224, 256, sf::Color::Black);
-
-    // Iterate over each pixel to set its color based on CPU memory and overlay
-    for (uint16_t y = 0; y < 224; y++) {     // Vertical axis
-        for (int16_t x = 0; x < 256; x++) {  // Horizontal axis
-            // Calculate memory offsets for pixel data
-            uint16_t memoryVerticalOffset = VERTICAL_OFFSET_MULTIPLIER * y;
-            uint16_t memoryHorizontalOffset = x >> 3;
-            uint16_t memoryAddress = MEMORY_BASE_OFFSET + memoryVerticalOffset + memoryHorizontalOffset;
-            uint8_t bitPosition = x % 8;
-
-            // Determine if the current pixel is on or off
-            bool pixelOn = (cpu.read(memoryAddress) & (1 << bitPosition)) != 0;
-
-            // Retrieve the overlay color for the current pixel if the pixel is on.
-            // Note: x and y are interchanged as the parameters due to rotation.
-            sf::Color pixelColor = pixelOn ? getOverlayColor(y, x) : sf::Color::Transparent;
-
-            // Set the pixel color with coordinates rotated counter-clockwise
-            image.setPixel(y, SCREEN_HEIGHT - x - 1, pixelColor);;
+    // Precompute the overlay once instead of per lit pixel.
+    // Note: getOverlayColor takes the VRAM column and bit position, i.e. the
+    // screen x and the distance from the bottom of the screen.
+    for (uint16_t row = 0; row < SCREEN_HEIGHT; row++) {
+        for (uint16_t column = 0; column < SCREEN_WIDTH; column++) {
+            sf::Color color = getOverlayColor(column, SCREEN_HEIGHT - row - 1);
+            overlay[pixelIndex(column, row)] = rgba(color.r, color.g, color.b, color.a);
         }
     }
+}
+
+void Display::draw(const VideoFrame& video) {
+#ifndef NDEBUG
+    uint64_t allocationsBefore = allocationCount();
+#endif
+
+    // Re-convert and re-upload only the strips whose VRAM page was written
+    // since the last frame drawn; most frames touch just a few of the 28
+    for (uint16_t strip = 0; strip < SCREEN_STRIPS; strip++) {
+        uint32_t version = video.stripVersions[strip];
+        if (!firstFrame && version == stripVersions[strip]) continue;
+        stripVersions[strip] = version;
+
+        convertStrip(video.vram.data(), overlay.data(), pixels.data(), strip);
+        texture.update(reinterpret_cast<const sf::Uint8*>(&pixels[strip * STRIP_PIXELS]),
+                       STRIP_WIDTH, SCREEN_HEIGHT, strip * STRIP_WIDTH, 0);
+    }
+    firstFrame = false;
 
-    // Convert image to texture and create sprite for rendering
-    texture.update(image);
-    sf::Sprite sprite(texture);
     window.clear();
     window.draw(backgroundSprite);
     window.draw(sprite);
 
     // Display on screen what has been rendered to the window so far
     window.display();
+
+#ifndef NDEBUG
+    // Once warmed up, a frame should not allocate. Report the first one that does.
+    constexpr uint64_t WARMUP_FRAMES = 60;
+    uint64_t allocations = allocationCount() - allocationsBefore;
+    if (++framesDrawn > WARMUP_FRAMES && allocations != 0 && !allocationsReported) {
+        std::cerr << "Display::draw: " << allocations << " heap allocation(s) in frame " << framesDrawn << std::endl;
+        allocationsReported = true;
+    }
+#endif
 }
 
 // The screen is 256 * 224 pixels, and is rotated anti-clockwise.
@@ -1,13 +1,15 @@
 #pragma once
 #include <SFML/Graphics.hpp>
 #include <SFML/System.hpp>
-#include "cpu.hpp"
+#include <array>
+#include "framebuffer.hpp"
+#include "machine.hpp"
 
 class Display {
 
 public:
     Display();
-    void draw(Intel8080& cpu);
+    void draw(const VideoFrame& video);
 
 public:
     sf::RenderWindow window;
@@ -16,6 +18,21 @@ private:
     sf::Texture texture;            // Texture for game graphics
     sf::Texture backgroundTexture;  // Texture for the background image
     sf::Sprite  backgroundSprite;   // Sprite for the background image
+    sf::Sprite  sprite;             // Sprite for the game graphics
+
+    // Strip-major RGBA images (see framebuffer.hpp), kept for the lifetime of
+    // the display so that drawing a frame never touches the heap
+    alignas(64) std::array<uint32_t, SCREEN_PIXELS> overlay;   // Colour of every screen position when lit (see getOverlayColor)
+    alignas(64) std::array<uint32_t, SCREEN_PIXELS> pixels;    // Image mirrored in the texture
+
+    // Memory::pageVersion of each strip's VRAM page when it was last converted
+    std::array<uint32_t, SCREEN_STRIPS> stripVersions;
+    bool firstFrame;
+
+#ifndef NDEBUG
+    uint64_t framesDrawn = 0;       // For reporting heap allocations made by draw() past start-up
+    bool     allocationsReported = false;
+#endif
 
     sf::Color getOverlayColor(uint8_t x, uint8_t y);
 };
\ No newline at end of file
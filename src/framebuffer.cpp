@@ -0,0 +1,84 @@
+#include "framebuffer.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+constexpr int COLUMN_BYTES = SCREEN_HEIGHT / 8;    // 32 bytes of VRAM per column
+
+// Transposes an 8x8 bit matrix held one row per byte: bit j of byte i
+// becomes bit i of byte j.
+// Source: Hacker's Delight, 2nd edition, section 7-3
+static inline uint64_t transpose8x8(uint64_t x) {
+    uint64_t t;
+    t = (x ^ (x >> 7))  & 0x00AA00AA00AA00AAULL;  x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;  x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;  x ^= t ^ (t << 28);
+    return x;
+}
+
+// Writes 8 pixels: overlay[i] where bit i of `bits` is set, transparent elsewhere
+static inline void expand8(uint8_t bits, const uint32_t* overlay, uint32_t* out) {
+#if defined(__AVX2__)
+    const __m256i select = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    __m256i lit = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(bits), select), select);
+    __m256i colour = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(overlay));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_and_si256(lit, colour));
+#elif defined(__SSE2__)
+    const __m128i selectLow  = _mm_setr_epi32(1, 2, 4, 8);
+    const __m128i selectHigh = _mm_setr_epi32(16, 32, 64, 128);
+    __m128i value = _mm_set1_epi32(bits);
+    __m128i litLow  = _mm_cmpeq_epi32(_mm_and_si128(value, selectLow), selectLow);
+    __m128i litHigh = _mm_cmpeq_epi32(_mm_and_si128(value, selectHigh), selectHigh);
+    __m128i colourLow  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(overlay));
+    __m128i colourHigh = _mm_loadu_si128(reinterpret_cast<const __m128i*>(overlay + 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_and_si128(litLow, colourLow));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_and_si128(litHigh, colourHigh));
+#else
+    for (int i = 0; i < 8; i++)
+        out[i] = overlay[i] & (0u - ((bits >> i) & 1u));
+#endif
+}
+
+// Writes 8 transparent pixels
+static inline void clear8(uint32_t* out) {
+#if defined(__AVX2__)
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_setzero_si256());
+#elif defined(__SSE2__)
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_setzero_si128());
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_setzero_si128());
+#else
+    for (int i = 0; i < 8; i++)
+        out[i] = 0;
+#endif
+}
+
+void convertStrip(const uint8_t* vram, const uint32_t* overlay, uint32_t* pixels, uint16_t strip) {
+    const uint8_t* source = vram + strip * STRIP_WIDTH * COLUMN_BYTES;
+    overlay += strip * STRIP_PIXELS;
+    pixels += strip * STRIP_PIXELS;
+
+    // Byte k of a column holds its pixels 8k..8k+7 counted from the bottom of
+    // the screen, so each k yields eight complete rows of the strip
+    for (int k = 0; k < COLUMN_BYTES; k++) {
+        uint64_t tile = 0;
+        for (int i = 0; i < STRIP_WIDTH; i++)
+            tile |= (uint64_t) source[i * COLUMN_BYTES + k] << (8 * i);
+        tile = transpose8x8(tile);
+
+        // Byte j of the tile is screen row 255 - (8k + j), bit i being column i of the strip
+        for (int j = 0; j < 8; j++) {
+            uint32_t row = (SCREEN_HEIGHT - 1 - (8 * k + j)) * STRIP_WIDTH;
+            uint8_t bits = (uint8_t) (tile >> (8 * j));
+            if (bits == 0) clear8(pixels + row);    // Most of the screen is black
+            else expand8(bits, overlay + row, pixels + row);
+        }
+    }
+}
+
+void convertFramebuffer(const uint8_t* vram, const uint32_t* overlay, uint32_t* pixels) {
+    for (uint16_t strip = 0; strip < SCREEN_STRIPS; strip++)
+        convertStrip(vram, overlay, pixels, strip);
+}
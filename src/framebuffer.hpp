@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+// The Space Invaders monitor is mounted rotated: video RAM holds 224 columns
+// of 256 pixels, one bit per pixel, and the screen shows them turned 90°
+// anticlockwise as a 224x256 image.
+constexpr uint16_t SCREEN_WIDTH  = 224;
+constexpr uint16_t SCREEN_HEIGHT = 256;
+constexpr uint32_t SCREEN_PIXELS = SCREEN_WIDTH * SCREEN_HEIGHT;
+
+// Each 256-byte page of video RAM is 8 consecutive columns, i.e. an 8-pixel
+// wide strip running the full height of the screen. Images are stored strip by
+// strip (strip s at pixel s * STRIP_PIXELS, each strip row-major 8 pixels wide)
+// so that a strip whose page changed is one contiguous texture sub-rectangle.
+constexpr uint16_t STRIP_WIDTH   = 8;
+constexpr uint16_t SCREEN_STRIPS = SCREEN_WIDTH / STRIP_WIDTH;
+constexpr uint32_t STRIP_PIXELS  = STRIP_WIDTH * SCREEN_HEIGHT;
+
+// Index of the pixel at screen position (x, y) in a strip-major image
+constexpr uint32_t pixelIndex(uint16_t x, uint16_t y) {
+    return (x / STRIP_WIDTH) * STRIP_PIXELS + y * STRIP_WIDTH + x % STRIP_WIDTH;
+}
+
+// A pixel as sf::Texture::update() expects it: R, G, B, A bytes in memory order
+// (little-endian host assumed)
+constexpr uint32_t rgba(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) {
+    return r | (uint32_t) g << 8 | (uint32_t) b << 16 | (uint32_t) a << 24;
+}
+
+// Expands one strip of 1bpp video RAM (0x2400-0x3FFF) into the rotated RGBA
+// image; `overlay` and `pixels` are strip-major screen images. A lit pixel
+// takes the colour at the same position in `overlay`; an unlit one is
+// transparent (0).
+//
+// The strip is handled in 8x8 tiles: eight column bytes are bit-transposed so
+// that each resulting byte holds the strip's eight pixels of one screen row,
+// which are then expanded to eight RGBA words at once (AVX2 when compiled
+// with it, SSE2 on any x86-64, scalar elsewhere).
+void convertStrip(const uint8_t* vram, const uint32_t* overlay, uint32_t* pixels, uint16_t strip);
+
+// Converts every strip
+void convertFramebuffer(const uint8_t* vram, const uint32_t* overlay, uint32_t* pixels);
@@ -0,0 +1,108 @@
+#include "framepacer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+FramePacer::FramePacer(Rate rate) : rate(rate), speedPermille(1000) {
+    updatePeriod();
+    reset();
+    resetStats();
+}
+
+void FramePacer::setRate(Rate newRate) {
+    rate = newRate;
+    updatePeriod();
+    reset();
+}
+
+void FramePacer::setSpeed(double multiplier) {
+    uint32_t permille = static_cast<uint32_t>(std::clamp(std::lround(multiplier * 1000), 1L, 1000000L));
+    if (permille == speedPermille) return;
+    speedPermille = permille;
+    updatePeriod();
+    reset();
+}
+
+// period = 1e9 * denominator / (numerator * speed) ns, split into whole
+// nanoseconds and a remainder so it never accumulates rounding error
+void FramePacer::updatePeriod() {
+    uint64_t dividend = 1'000'000'000ULL * rate.denominator * 1000;
+    periodDivisor = static_cast<uint64_t>(rate.numerator) * speedPermille;
+    periodNs = static_cast<int64_t>(dividend / periodDivisor);
+    periodRemainder = dividend % periodDivisor;
+}
+
+void FramePacer::reset() {
+    remainder = 0;
+    deadline = Clock::now();
+    advance();
+    lastReturn = Clock::time_point();
+}
+
+void FramePacer::advance() {
+    int64_t ns = periodNs;
+    remainder += periodRemainder;
+    if (remainder >= periodDivisor) {
+        remainder -= periodDivisor;
+        ns++;
+    }
+    deadline += std::chrono::nanoseconds(ns);
+}
+
+int FramePacer::wait() {
+    Clock::time_point now = Clock::now();
+    if (now < deadline) {
+        std::this_thread::sleep_until(deadline);
+        now = Clock::now();
+    }
+    if (now - deadline > std::chrono::duration<double, std::milli>(LATE_MS)) late++;
+
+    // Every deadline that has passed is a frame due
+    int due = 0;
+    while (deadline <= now && due < MAX_CATCH_UP) {
+        advance();
+        due++;
+    }
+
+    // Too far behind (debugger, window drag, slow host): drop the backlog
+    // rather than fast-forwarding through it
+    while (deadline <= now) {
+        advance();
+        dropped++;
+    }
+
+    record(now);
+    return due;
+}
+
+void FramePacer::record(Clock::time_point now) {
+    if (lastReturn != Clock::time_point()) {
+        double ms = std::chrono::duration<double, std::milli>(now - lastReturn).count();
+        frames++;
+        double delta = ms - mean;
+        mean += delta / frames;
+        m2 += delta * (ms - mean);
+        minMs = std::min(minMs, ms);
+        maxMs = std::max(maxMs, ms);
+    }
+    lastReturn = now;
+}
+
+FramePacer::Stats FramePacer::stats() const {
+    Stats s{};
+    s.frames = frames;
+    s.meanMs = mean;
+    s.minMs = frames ? minMs : 0;
+    s.maxMs = maxMs;
+    s.jitterMs = frames > 1 ? std::sqrt(m2 / (frames - 1)) : 0;
+    s.late = late;
+    s.dropped = dropped;
+    return s;
+}
+
+void FramePacer::resetStats() {
+    frames = late = dropped = 0;
+    mean = m2 = maxMs = 0;
+    minMs = INFINITY;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// Paces the emulation to the video refresh rate on the monotonic clock.
+//
+// Frame deadlines are kept exactly: the frame period (1 / rate / speed) is an
+// integer number of nanoseconds plus a fraction carried in an integer
+// remainder, so 59.94 Hz (60000/1001) stays locked to wall time over hours.
+// wait() sleeps until the next deadline rather than polling, and reports
+// how many frames are due, so a loop that falls behind catches up by running
+// extra frames instead of slowing the game down.
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Frames per second as a fraction
+    struct Rate {
+        uint32_t numerator;
+        uint32_t denominator;
+    };
+    static constexpr Rate HZ_60    = {60, 1};
+    static constexpr Rate HZ_59_94 = {60000, 1001};
+
+    // Frame-to-frame interval statistics since construction or resetStats()
+    struct Stats {
+        uint64_t frames;        // Intervals measured between consecutive wait() returns
+        double   meanMs;
+        double   minMs;
+        double   maxMs;
+        double   jitterMs;      // Standard deviation of the interval
+        uint64_t late;          // Woke up more than LATE_MS past the deadline
+        uint64_t dropped;       // Frames skipped after falling more than MAX_CATCH_UP frames behind
+    };
+
+    static constexpr int    MAX_CATCH_UP = 4;       // Frames wait() will return at once before giving up on them
+    static constexpr double LATE_MS      = 2.0;
+
+    explicit FramePacer(Rate rate = HZ_60);
+
+    void  setRate(Rate rate);
+    void  setSpeed(double multiplier);      // 1 = real time, 2 = fast-forward, 0.5 = slow motion
+    double speed() const                    { return speedPermille / 1000.0; }
+    void  reset();                          // Restart the schedule from now, e.g. after a pause
+    int   wait();                           // Sleep until the next deadline; returns the number of frames due
+    Stats stats() const;
+    void  resetStats();
+
+private:
+    Rate              rate;
+    uint32_t          speedPermille;        // Speed multiplier in thousandths, keeps the period arithmetic integral
+
+    Clock::time_point deadline;             // When the next frame is due
+    int64_t           periodNs;             // Whole nanoseconds of the frame period
+    uint64_t          periodRemainder;      // and its fraction, in 1/periodDivisor ns
+    uint64_t          periodDivisor;
+    uint64_t          remainder;            // Accumulated fraction
+
+    Clock::time_point lastReturn;
+    uint64_t          frames, late, dropped;
+    double            mean, m2, minMs, maxMs;   // Welford's running mean and variance
+
+    void updatePeriod();
+    void advance();                         // Move the deadline on by one period
+    void record(Clock::time_point now);
+};
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 64-bit FNV-1a hash, used to compare machine states across runs and to
+// recognise ROM images
+uint64_t fnv1a(const uint8_t* data, size_t size);
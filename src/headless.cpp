@@ -0,0 +1,256 @@
+#include "allocations.hpp"
+#include "machinepool.hpp"
+#include "movie.hpp"
+#include "romset.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// Headless batch runner: emulates Space Invaders without a window, audio or
+// wall-clock throttling, then reports hashes of the final machine state.
+//
+// Usage: Intel_8080_headless [options]
+//   --rom PATH         Program ROM as a single image (default: invaders)
+//   --romset DIR       Space Invaders ROM chips invaders.h-e in DIR, CRC-checked
+//   --manifest PATH    ROM set described by a manifest (see loadManifest), chips next to it
+//   --frames N         Number of 60 Hz frames to emulate (default: 3600, or the movie's length)
+//   --input PATH       Input script, one "<frame> <button> <0|1>" event per line
+//   --record PATH      Write the run's inputs and per-frame RAM hashes to a movie file
+//   --replay PATH      Take the inputs from a movie file and check every frame's RAM hash
+//   --engine NAME      table | switch | block | jit | aot
+//   --no-idle-skip     Run HLT and idle wait loops instruction by instruction
+//   --trace PATH       Write a binary trace of every instruction (see tools/tracetool.cpp)
+//   --trace-from N     Start the trace at frame N (default: 0)
+//   --dump-ram PATH    Write the final 8 KB of RAM (0x2000-0x3FFF) to a file
+//   --machines N       Run N identical machines in parallel (default: 1)
+//   --threads N        Worker threads for --machines (default: all cores)
+
+struct InputEvent {
+    uint64_t frame;
+    Button   button;
+    bool     pressed;
+};
+
+static void usage() {
+    fprintf(stderr, "Usage: Intel_8080_headless [--rom PATH | --romset DIR | --manifest PATH] [--frames N] [--input PATH] "
+                    "[--record PATH | --replay PATH] [--engine table|switch|block|jit|aot] [--no-idle-skip] [--trace PATH [--trace-from N]] [--dump-ram PATH] [--machines N] [--threads N]\n");
+}
+
+static bool parseButton(const std::string& name, Button& button) {
+    if      (name == "coin")    button = Button::Coin;
+    else if (name == "p2start") button = Button::P2Start;
+    else if (name == "p1start") button = Button::P1Start;
+    else if (name == "fire")    button = Button::Fire;
+    else if (name == "left")    button = Button::Left;
+    else if (name == "right")   button = Button::Right;
+    else return false;
+    return true;
+}
+
+// Reads an input script. Blank lines and lines starting with '#' are ignored.
+//   # frame  button   state
+//   100      coin     1
+//   110      coin     0
+static bool loadInputScript(const std::string& filePath, std::vector<InputEvent>& events) {
+    std::ifstream file(filePath);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open input script: " << filePath << std::endl;
+        return false;
+    }
+
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); lineNumber++) {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        InputEvent event{};
+        std::string buttonName;
+        int state;
+        if (!(fields >> event.frame >> buttonName >> state) || !parseButton(buttonName, event.button)) {
+            std::cerr << filePath << ":" << lineNumber << ": expected \"<frame> <button> <0|1>\"" << std::endl;
+            return false;
+        }
+        event.pressed = state != 0;
+        events.push_back(event);
+    }
+
+    std::stable_sort(events.begin(), events.end(),
+                     [](const InputEvent& a, const InputEvent& b) { return a.frame < b.frame; });
+    return true;
+}
+
+static bool parseEngine(const std::string& name, Intel8080::Dispatch& dispatch) {
+    if      (name == "table")  dispatch = Intel8080::Dispatch::Table;
+    else if (name == "switch") dispatch = Intel8080::Dispatch::Switch;
+    else if (name == "block")  dispatch = Intel8080::Dispatch::Block;
+    else if (name == "jit")    dispatch = Intel8080::Dispatch::Jit;
+    else if (name == "aot")    dispatch = Intel8080::Dispatch::Aot;
+    else return false;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::string romPath = "invaders";
+    std::string romSetDirectory;
+    std::string manifestPath;
+    std::string inputPath;
+    std::string ramDumpPath;
+    std::string recordPath;
+    std::string replayPath;
+    std::string tracePath;
+    uint64_t traceFrom = 0;
+    std::optional<uint64_t> frames;
+    size_t machineCount = 1;
+    unsigned threadCount = std::thread::hardware_concurrency();
+    std::optional<Intel8080::Dispatch> dispatch;
+    bool idleSkip = true;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if      (arg == "--rom" && hasValue)      romPath = argv[++i];
+        else if (arg == "--romset" && hasValue)   romSetDirectory = argv[++i];
+        else if (arg == "--manifest" && hasValue) manifestPath = argv[++i];
+        else if (arg == "--frames" && hasValue)   frames = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--input" && hasValue)    inputPath = argv[++i];
+        else if (arg == "--record" && hasValue)   recordPath = argv[++i];
+        else if (arg == "--replay" && hasValue)   replayPath = argv[++i];
+        else if (arg == "--dump-ram" && hasValue) ramDumpPath = argv[++i];
+        else if (arg == "--machines" && hasValue) machineCount = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--threads" && hasValue)  threadCount = strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--no-idle-skip")         idleSkip = false;
+        else if (arg == "--trace" && hasValue)    tracePath = argv[++i];
+        else if (arg == "--trace-from" && hasValue) traceFrom = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--engine" && hasValue) {
+            Intel8080::Dispatch engine;
+            if (!parseEngine(argv[++i], engine)) {
+                usage();
+                return 1;
+            }
+            dispatch = engine;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (machineCount == 0 || (!replayPath.empty() && (!inputPath.empty() || !recordPath.empty())) ||
+        (!tracePath.empty() && machineCount > 1)) {
+        usage();
+        return 1;
+    }
+
+    std::vector<InputEvent> events;
+    if (!inputPath.empty() && !loadInputScript(inputPath, events)) return 1;
+
+    MachinePool pool(machineCount, threadCount);
+    if (!manifestPath.empty()) {
+        RomSet set;
+        std::vector<uint8_t> rom;
+        size_t slash = manifestPath.find_last_of("/\\");
+        std::string directory = slash == std::string::npos ? "" : manifestPath.substr(0, slash);
+        if (!loadManifest(manifestPath, set) || !loadRomSet(set, directory, rom) || !pool.load(rom)) return 1;
+    } else if (!romSetDirectory.empty()) {
+        std::vector<uint8_t> rom;
+        if (!loadRomSet(SPACE_INVADERS, romSetDirectory, rom) || !pool.load(rom)) return 1;
+    } else if (!pool.load(romPath)) {
+        return 1;
+    }
+    if (dispatch) pool.setDispatch(*dispatch);
+    pool.setIdleSkip(idleSkip);
+
+    Movie movie;
+    if (!replayPath.empty()) {
+        if (!movie.load(replayPath)) return 1;
+        if (movie.romHash() != pool.machine(0).romHash()) {
+            std::cerr << "Movie was recorded with a different ROM: " << replayPath << std::endl;
+            return 1;
+        }
+        frames = std::min(frames.value_or(movie.frames()), movie.frames());
+    } else if (!recordPath.empty()) {
+        movie.start(pool.machine(0).romHash());
+    }
+    uint64_t frameCount = frames.value_or(3600);
+
+    std::unique_ptr<BinaryFileTrace> trace;
+    if (!tracePath.empty()) {
+        trace = std::make_unique<BinaryFileTrace>(tracePath);
+        if (!trace->isOpen()) return 1;
+    }
+
+    uint64_t allocationsBefore = allocationCount();
+    auto start = std::chrono::steady_clock::now();
+    size_t nextEvent = 0;
+    std::optional<uint64_t> divergedAt;
+    for (uint64_t frame = 0; frame < frameCount; frame++) {
+        // Inputs are latched at frame boundaries
+        if (!replayPath.empty()) {
+            for (size_t m = 0; m < pool.size(); m++)
+                pool.machine(m).setInputs(movie.inputs(frame));
+        }
+        for (; nextEvent < events.size() && events[nextEvent].frame <= frame; nextEvent++)
+            for (size_t m = 0; m < pool.size(); m++)
+                pool.machine(m).setButton(events[nextEvent].button, events[nextEvent].pressed);
+        uint8_t inputs = pool.machine(0).inputs();
+
+        if (trace && frame >= traceFrom)
+            pool.machine(0).runFrame(*trace);
+        else
+            pool.runFrames();
+
+        if (!recordPath.empty())
+            movie.record(inputs, pool.machine(0).ramHash());
+        if (!replayPath.empty() && !divergedAt && pool.machine(0).ramHash() != movie.ramHash(frame))
+            divergedAt = frame;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    uint64_t allocations = allocationCount() - allocationsBefore;
+
+    // Every machine got the same ROM and inputs, so they must all agree
+    size_t mismatches = 0;
+    for (size_t m = 1; m < pool.size(); m++)
+        if (pool.machine(m).ramHash() != pool.machine(0).ramHash()) mismatches++;
+
+    const Machine& machine = pool.machine(0);
+    printf("frames:            %llu\n", (unsigned long long) frameCount);
+    if (pool.size() > 1)
+        printf("machines:          %zu on %u threads\n", pool.size(), pool.threadCount());
+    printf("time:              %.3f s (%.0f frames/s)\n", elapsed.count(), frameCount * pool.size() / elapsed.count());
+    printf("framebuffer hash:  %016llx\n", (unsigned long long) machine.videoRamHash());
+    printf("ram hash:          %016llx\n", (unsigned long long) machine.ramHash());
+    if (uint64_t idle = machine.cpu.idleCycles())
+        printf("idle skipped:      %llu cycles (%.1f%%)\n", (unsigned long long) idle, 100.0 * idle / machine.cycleCount());
+    if (uint64_t illegal = machine.cpu.memory->illegalWrites())
+        printf("illegal writes:    %llu (to ROM or unmapped memory)\n", (unsigned long long) illegal);
+#ifndef NDEBUG
+    printf("heap allocations:  %llu\n", (unsigned long long) allocations);
+#else
+    (void) allocations;
+#endif
+    if (!replayPath.empty())
+        printf("replay:            %s\n", divergedAt ? ("diverged at frame " + std::to_string(*divergedAt)).c_str() : "every frame matches");
+    if (mismatches) {
+        std::cerr << mismatches << " machine(s) diverged from machine 0" << std::endl;
+        return 1;
+    }
+    if (divergedAt) return 1;
+    if (!recordPath.empty() && !movie.save(recordPath)) return 1;
+
+    if (!ramDumpPath.empty()) {
+        std::ofstream dump(ramDumpPath, std::ios::binary);
+        dump.write(reinterpret_cast<const char*>(machine.ram()), RAM_BYTES);
+        if (!dump) {
+            std::cerr << "Failed to write RAM dump: " << ramDumpPath << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
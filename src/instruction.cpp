@@ -0,0 +1,95 @@
+#include "instruction.hpp"
+#include "memory.hpp"
+
+#include <cstdio>
+
+static constexpr const char* MNEMONIC_NAMES[MNEMONIC_COUNT] = {
+    "ACI", "ADC", "ADD", "ADI", "ANA", "ANI", "CALL", "C", "CMA", "CMC", "CMP", "CPI", "DAA", "DAD",
+    "DCR", "DCX", "DI", "EI", "HLT", "IN", "INR", "INX", "J", "JMP", "LDA", "LDAX", "LHLD", "LXI",
+    "MOV", "MVI", "NOP", "ORA", "ORI", "OUT", "PCHL", "POP", "PUSH", "RAL", "RAR", "R", "RET", "RLC",
+    "RRC", "RST", "SBB", "SBI", "SHLD", "SPHL", "STA", "STAX", "STC", "SUB", "SUI", "XCHG", "XRA",
+    "XRI", "XTHL",
+};
+
+static constexpr const char* CONDITION_NAMES[8] = {"NZ", "Z", "NC", "C", "PO", "PE", "P", "M"};
+static constexpr const char* REGISTER_NAMES[8]  = {"B", "C", "D", "E", "H", "L", "M", "A"};
+static constexpr const char* PAIR_NAMES[4]      = {"B", "D", "H", "SP"};
+static constexpr const char* PAIR_PSW_NAMES[4]  = {"B", "D", "H", "PSW"};
+
+Instruction decode(uint16_t pc, uint8_t opcode, const uint8_t operands[2]) {
+    const OpcodeInfo& info = OPCODES[opcode];
+    Instruction instruction{};
+    instruction.pc = pc;
+    instruction.opcode = opcode;
+    instruction.mnemonic = info.mnemonic;
+    for (int i = 0; i < 2; i++) {
+        instruction.operands[i] = info.operands[i];
+        instruction.values[i] = info.values[i];
+    }
+    instruction.condition = info.condition;
+    instruction.length = info.length;
+    instruction.cycles = info.cycles;
+    instruction.cyclesNotTaken = info.cyclesNotTaken;
+    instruction.flags = info.flags;
+
+    if (info.length == 2) instruction.imm = operands[0];
+    if (info.length == 3) instruction.imm = operands[0] | operands[1] << 8;
+
+    if (info.operands[0] == Operand::Target) {
+        instruction.target = instruction.imm;
+        instruction.hasTarget = true;
+    } else if (info.mnemonic == Mnemonic::RST) {
+        instruction.target = info.values[0] * 8;
+        instruction.hasTarget = true;
+    }
+    return instruction;
+}
+
+Instruction decode(const Memory& memory, uint16_t pc) {
+    uint8_t operands[2] = { memory.read(pc + 1), memory.read(pc + 2) };
+    return decode(pc, memory.read(pc), operands);
+}
+
+size_t decodeRange(const Memory& memory, uint16_t start, uint16_t end, Instruction* out, size_t capacity) {
+    size_t count = 0;
+    for (uint32_t pc = start; pc <= end && pc < RAM_SIZE && count < capacity; count++) {
+        out[count] = decode(memory, static_cast<uint16_t>(pc));
+        pc += out[count].length;
+    }
+    return count;
+}
+
+size_t format(const Instruction& instruction, char* buffer, size_t size) {
+    char name[8];
+    const char* base = MNEMONIC_NAMES[static_cast<size_t>(instruction.mnemonic)];
+    bool conditional = instruction.mnemonic == Mnemonic::Jccc || instruction.mnemonic == Mnemonic::Cccc ||
+                       instruction.mnemonic == Mnemonic::Rccc;
+    snprintf(name, sizeof(name), "%s%s%s", instruction.flags & OpcodeInfo::UNDOCUMENTED ? "*" : "", base,
+             conditional ? CONDITION_NAMES[instruction.condition] : "");
+
+    char operands[2][8] = {};
+    for (int i = 0; i < 2; i++) {
+        uint8_t value = instruction.values[i];
+        switch (instruction.operands[i]) {
+            case Operand::None:     break;
+            case Operand::Reg:      snprintf(operands[i], sizeof(operands[i]), "%s", REGISTER_NAMES[value]);   break;
+            case Operand::Pair:     snprintf(operands[i], sizeof(operands[i]), "%s", PAIR_NAMES[value]);       break;
+            case Operand::PairPSW:  snprintf(operands[i], sizeof(operands[i]), "%s", PAIR_PSW_NAMES[value]);   break;
+            case Operand::Imm8:
+            case Operand::Port:     snprintf(operands[i], sizeof(operands[i]), "#$%02x", instruction.imm);     break;
+            case Operand::Imm16:    snprintf(operands[i], sizeof(operands[i]), "#$%04x", instruction.imm);     break;
+            case Operand::Address:
+            case Operand::Target:   snprintf(operands[i], sizeof(operands[i]), "$%04x", instruction.imm);      break;
+            case Operand::Vector:   snprintf(operands[i], sizeof(operands[i]), "%d", value);                   break;
+        }
+    }
+
+    int length;
+    if (instruction.operands[0] == Operand::None)
+        length = snprintf(buffer, size, "%s", name);
+    else if (instruction.operands[1] == Operand::None)
+        length = snprintf(buffer, size, "%-6s%s", name, operands[0]);
+    else
+        length = snprintf(buffer, size, "%-6s%s,%s", name, operands[0], operands[1]);
+    return length < 0 ? 0 : static_cast<size_t>(length);
+}
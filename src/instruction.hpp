@@ -0,0 +1,264 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+class Memory;
+
+// The 8080 instruction set as data: one OpcodeInfo per opcode, built at
+// compile time from the opcode bit fields. The CPU's handler table, the
+// block cache, the disassembler and the tools all read it, so there is a
+// single place that knows how long an instruction is, what it costs and
+// where it can branch.
+// Source: http://dunfield.classiccmp.org/r/8080.txt
+
+enum class Mnemonic : uint8_t {
+    ACI,    // Add Immediate with Carry
+    ADC,    // Add with Carry
+    ADD,    // Add without Carry
+    ADI,    // Add Immediate (without carry)
+    ANA,    // AND Accumulator (logical AND)
+    ANI,    // AND Immediate with Accumulator
+    CALL,   // Call Subroutine
+    Cccc,   // Conditional call (CNZ, CZ, CNC, CC, CPO, CPE, CP, CM)
+    CMA,    // Complement Accumulator
+    CMC,    // Complement Carry Flag
+    CMP,    // Compare Accumulator with Register
+    CPI,    // Compare Immediate with Accumulator
+    DAA,    // Decimal Adjust Accumulator
+    DAD,    // Double Add (Add register pair to HL)
+    DCR,    // Decrement Register or Memory
+    DCX,    // Decrement Register Pair
+    DI,     // Disable Interrupts
+    EI,     // Enable Interrupts
+    HLT,    // Halt
+    IN,     // Input from Port
+    INR,    // Increment Register or Memory
+    INX,    // Increment Register Pair
+    Jccc,   // Conditional jump (JNZ, JZ, JNC, JC, JPO, JPE, JP, JM)
+    JMP,    // Jump Unconditionally
+    LDA,    // Load Accumulator Directly from Memory
+    LDAX,   // Load Accumulator Indirectly (from BC or DE)
+    LHLD,   // Load HL pair Direct from memory
+    LXI,    // Load register pair Immediate
+    MOV,    // Move data between registers or between register and memory
+    MVI,    // Move Immediate data to register or memory
+    NOP,    // No Operation
+    ORA,    // OR Accumulator (logical OR)
+    ORI,    // OR Immediate with Accumulator
+    OUT,    // Output to Port
+    PCHL,   // Move HL to Program Counter
+    POP,    // Pop data from stack to register pair
+    PUSH,   // Push register pair data onto stack
+    RAL,    // Rotate Accumulator Left through Carry
+    RAR,    // Rotate Accumulator Right through Carry
+    Rccc,   // Conditional return (RNZ, RZ, RNC, RC, RPO, RPE, RP, RM)
+    RET,    // Return from subroutine
+    RLC,    // Rotate Accumulator Left
+    RRC,    // Rotate Accumulator Right
+    RST,    // Restart (call to fixed address)
+    SBB,    // Subtract with Borrow (accumulator - register - carry)
+    SBI,    // Subtract Immediate with Borrow
+    SHLD,   // Store HL Direct to memory
+    SPHL,   // Move HL to Stack Pointer
+    STA,    // Store Accumulator Directly in Memory
+    STAX,   // Store Accumulator Indirectly (into address pointed by BC or DE)
+    STC,    // Set Carry
+    SUB,    // Subtract without carry
+    SUI,    // Subtract Immediate (without carry)
+    XCHG,   // Exchange HL with DE
+    XRA,    // Exclusive OR Accumulator
+    XRI,    // Exclusive OR Immediate with Accumulator
+    XTHL,   // Exchange Top of stack with HL
+};
+constexpr size_t MNEMONIC_COUNT = static_cast<size_t>(Mnemonic::XTHL) + 1;
+
+enum class Operand : uint8_t {
+    None,
+    Reg,        // 8-bit register, value 0-7: B, C, D, E, H, L, M (memory at HL), A
+    Pair,       // Register pair, value 0-3: B, D, H, SP
+    PairPSW,    // PUSH/POP register pair, value 0-3: B, D, H, PSW
+    Imm8,       // Immediate byte
+    Imm16,      // Immediate word
+    Address,    // Memory address of a load or store
+    Target,     // Jump or call destination
+    Port,       // I/O port number
+    Vector,     // RST number, value 0-7
+};
+
+struct OpcodeInfo {
+    enum Flags : uint8_t {
+        JUMP          = 1 << 0,     // Transfers control without returning (JMP, Jccc, PCHL)
+        CALL          = 1 << 1,     // Pushes the return address (CALL, Cccc, RST)
+        RETURN        = 1 << 2,     // RET, Rccc
+        CONDITIONAL   = 1 << 3,     // The transfer depends on a flag (Jccc, Cccc, Rccc)
+        WRITES_MEMORY = 1 << 4,     // May store to memory (MOV M, STA, PUSH, ...)
+        HALTS         = 1 << 5,     // HLT
+        UNDOCUMENTED  = 1 << 6,     // An alias of another opcode; the CPU treats it as illegal
+    };
+
+    Mnemonic mnemonic;
+    Operand  operands[2];
+    uint8_t  values[2];         // Register, pair or RST number for Reg, Pair, PairPSW and Vector operands
+    uint8_t  condition;         // Jccc, Cccc and Rccc: 0-7 = NZ, Z, NC, C, PO, PE, P, M
+    uint8_t  length;            // In bytes, 1-3
+    uint8_t  cycles;            // Cycle cost, the taken path for conditional calls and returns
+    uint8_t  cyclesNotTaken;    // Same as `cycles` except for Cccc and Rccc
+    uint8_t  flags;             // Flags
+
+    bool endsBlock() const      { return flags & (JUMP | CALL | RETURN | HALTS | UNDOCUMENTED); }
+};
+
+// The entry for one opcode, from its bit fields:
+//   01 ddd sss  MOV d,s        00 ddd 1xx  INR/DCR/MVI d     00 rp0 001  LXI rp
+//   10 ooo sss  ALU s          11 ooo 110  ALU immediate     11 nnn 111  RST n
+//   11 ccc 0x0  Rccc/Jccc      11 ccc 100  Cccc              11 rp0 x01  POP/PUSH rp
+constexpr OpcodeInfo describe(uint8_t op) {
+    using M = Mnemonic;
+    using O = Operand;
+    using F = OpcodeInfo;
+    OpcodeInfo info{M::NOP, {O::None, O::None}, {0, 0}, 0, 1, 4, 4, 0};
+    uint8_t dst = (op >> 3) & 7;
+    uint8_t src = op & 7;
+    uint8_t pair = (op >> 4) & 3;
+
+    auto set = [&](M mnemonic, uint8_t cycles, O first = O::None, uint8_t firstValue = 0,
+                   O second = O::None, uint8_t secondValue = 0) {
+        info.mnemonic = mnemonic;
+        info.operands[0] = first;
+        info.operands[1] = second;
+        info.values[0] = firstValue;
+        info.values[1] = secondValue;
+        info.cycles = info.cyclesNotTaken = cycles;
+        for (O operand : info.operands) {
+            if (operand == O::Imm8 || operand == O::Port) info.length = 2;
+            if (operand == O::Imm16 || operand == O::Address || operand == O::Target) info.length = 3;
+        }
+    };
+
+    if (op == 0x76) {
+        set(M::HLT, 7);
+        info.flags = F::HALTS;
+    } else if (op >= 0x40 && op < 0x80) {
+        set(M::MOV, dst == 6 || src == 6 ? 7 : 5, O::Reg, dst, O::Reg, src);
+        if (dst == 6) info.flags = F::WRITES_MEMORY;
+    } else if (op >= 0x80 && op < 0xC0) {
+        constexpr M alu[8] = {M::ADD, M::ADC, M::SUB, M::SBB, M::ANA, M::XRA, M::ORA, M::CMP};
+        set(alu[dst], src == 6 ? 7 : 4, O::Reg, src);
+    } else if (op < 0x40) {
+        switch (op & 0x0F) {
+            case 0x01: set(M::LXI, 10, O::Pair, pair, O::Imm16);   break;
+            case 0x03: set(M::INX, 5, O::Pair, pair);              break;
+            case 0x09: set(M::DAD, 10, O::Pair, pair);             break;
+            case 0x0B: set(M::DCX, 5, O::Pair, pair);              break;
+            default:                                                break;
+        }
+        switch (op & 0x07) {
+            case 0x04: set(M::INR, dst == 6 ? 10 : 5, O::Reg, dst);        break;
+            case 0x05: set(M::DCR, dst == 6 ? 10 : 5, O::Reg, dst);        break;
+            case 0x06: set(M::MVI, dst == 6 ? 10 : 7, O::Reg, dst, O::Imm8); break;
+            default:                                                        break;
+        }
+        if ((op & 0x07) >= 4 && (op & 0x07) <= 6 && dst == 6) info.flags = F::WRITES_MEMORY;
+        switch (op) {
+            case 0x02: case 0x12: set(M::STAX, 7, O::Pair, pair); info.flags = F::WRITES_MEMORY; break;
+            case 0x0A: case 0x1A: set(M::LDAX, 7, O::Pair, pair);                            break;
+            case 0x22: set(M::SHLD, 16, O::Address); info.flags = F::WRITES_MEMORY;              break;
+            case 0x2A: set(M::LHLD, 16, O::Address);                                          break;
+            case 0x32: set(M::STA, 13, O::Address); info.flags = F::WRITES_MEMORY;               break;
+            case 0x3A: set(M::LDA, 13, O::Address);                                           break;
+            case 0x07: set(M::RLC, 4); break;
+            case 0x0F: set(M::RRC, 4); break;
+            case 0x17: set(M::RAL, 4); break;
+            case 0x1F: set(M::RAR, 4); break;
+            case 0x27: set(M::DAA, 4); break;
+            case 0x2F: set(M::CMA, 4); break;
+            case 0x37: set(M::STC, 4); break;
+            case 0x3F: set(M::CMC, 4); break;
+            case 0x00: set(M::NOP, 4); break;
+            case 0x08: case 0x10: case 0x18: case 0x20: case 0x28: case 0x30: case 0x38:
+                set(M::NOP, 4);
+                info.flags = F::UNDOCUMENTED;
+                break;
+            default:
+                break;
+        }
+    } else {
+        constexpr M immediate[8] = {M::ADI, M::ACI, M::SUI, M::SBI, M::ANI, M::XRI, M::ORI, M::CPI};
+        switch (op & 0x07) {
+            case 0x00: set(M::Rccc, 11); info.cyclesNotTaken = 5; info.flags = F::RETURN | F::CONDITIONAL; break;
+            case 0x02: set(M::Jccc, 10, O::Target); info.flags = F::JUMP | F::CONDITIONAL;                  break;
+            case 0x04: set(M::Cccc, 17, O::Target); info.cyclesNotTaken = 11;
+                       info.flags = F::CALL | F::CONDITIONAL | F::WRITES_MEMORY;                                break;
+            case 0x06: set(immediate[dst], 7, O::Imm8);                                               break;
+            case 0x07: set(M::RST, 11, O::Vector, dst); info.flags = F::CALL | F::WRITES_MEMORY;            break;
+            default:   break;
+        }
+        info.condition = (op & 0x07) == 0x00 || (op & 0x07) == 0x02 || (op & 0x07) == 0x04 ? dst : 0;
+        switch (op) {
+            case 0xC1: case 0xD1: case 0xE1: case 0xF1: set(M::POP, 10, O::PairPSW, pair);   break;
+            case 0xC5: case 0xD5: case 0xE5: case 0xF5: set(M::PUSH, 11, O::PairPSW, pair);
+                                                        info.flags = F::WRITES_MEMORY;            break;
+            case 0xC3: set(M::JMP, 10, O::Target); info.flags = F::JUMP;                           break;
+            case 0xC9: set(M::RET, 10); info.flags = F::RETURN;                                    break;
+            case 0xCD: set(M::CALL, 17, O::Target); info.flags = F::CALL | F::WRITES_MEMORY;          break;
+            case 0xD3: set(M::OUT, 10, O::Port);                                                break;
+            case 0xDB: set(M::IN, 10, O::Port);                                                 break;
+            case 0xE3: set(M::XTHL, 18); info.flags = F::WRITES_MEMORY;                            break;
+            case 0xE9: set(M::PCHL, 5); info.flags = F::JUMP;                                      break;
+            case 0xEB: set(M::XCHG, 5);                                                         break;
+            case 0xF3: set(M::DI, 4);                                                           break;
+            case 0xF9: set(M::SPHL, 5);                                                         break;
+            case 0xFB: set(M::EI, 4);                                                           break;
+            case 0xCB: set(M::JMP, 10, O::Target); info.flags = F::JUMP | F::UNDOCUMENTED;            break;
+            case 0xD9: set(M::RET, 10); info.flags = F::RETURN | F::UNDOCUMENTED;                     break;
+            case 0xDD: case 0xED: case 0xFD:
+                set(M::CALL, 17, O::Target);
+                info.flags = F::CALL | F::WRITES_MEMORY | F::UNDOCUMENTED;
+                break;
+            default:
+                break;
+        }
+    }
+    return info;
+}
+
+inline constexpr std::array<OpcodeInfo, 256> OPCODES = [] {
+    std::array<OpcodeInfo, 256> table{};
+    for (int op = 0; op < 256; op++)
+        table[op] = describe(static_cast<uint8_t>(op));
+    return table;
+}();
+
+// One decoded instruction
+struct Instruction {
+    uint16_t pc;                // Address of the opcode
+    uint8_t  opcode;
+    Mnemonic mnemonic;
+    Operand  operands[2];
+    uint8_t  values[2];         // See OpcodeInfo::values
+    uint8_t  condition;         // See OpcodeInfo::condition
+    uint8_t  length;
+    uint8_t  cycles;
+    uint8_t  cyclesNotTaken;
+    uint8_t  flags;             // OpcodeInfo::Flags
+    uint16_t imm;               // Immediate byte or word, address or port; 0 if none
+    uint16_t target;            // Destination of a jump, call or RST, if hasTarget
+    bool     hasTarget;         // False for RET, PCHL and everything that does not branch
+
+    bool endsBlock() const      { return OPCODES[opcode].endsBlock(); }
+};
+
+// Decodes the instruction at `pc` from its opcode and the two bytes after it
+Instruction decode(uint16_t pc, uint8_t opcode, const uint8_t operands[2]);
+Instruction decode(const Memory& memory, uint16_t pc);
+
+// Decodes consecutive instructions from `start` until one begins past `end`,
+// `out` is full or the address space ends. Returns the number decoded.
+size_t decodeRange(const Memory& memory, uint16_t start, uint16_t end, Instruction* out, size_t capacity);
+
+// Writes the instruction as assembly ("MVI   A,#$3f", "JNZ   $1a2b") into
+// `buffer`, always terminated, and returns the length it needed like
+// snprintf. Undocumented opcodes are marked with a '*'. 24 bytes always fit.
+size_t format(const Instruction& instruction, char* buffer, size_t size);
@@ -38,10 +38,10 @@
 uint8_t IOPorts::read(uint8_t port) {
     switch (port) {
         case 0:     return 0xFF;
-        case 1:     return inPort1;
+        case 1:     return inPort1.load(std::memory_order_relaxed);
         case 2:     return 0;
         case 3:     return (shiftRegister >> (8 - shiftOffset)) & 0xFF; // bit shift register read
-        default:    return inPort1;
+        default:    return inPort1.load(std::memory_order_relaxed);
     }
 }
 
@@ -75,7 +75,7 @@ uint8_t IOPorts::read(uint8_t port) {
 // Watchdog ... read or write to reset
 //
 // Source: http://computerarcheology.com/Arcade/SpaceInvaders/Hardware.html
-void IOPorts::write(uint8_t port, uint8_t data) {
+void IOPorts::write(uint8_t port, uint8_t data, uint64_t cycle) {
     switch (port) {
         case 2:                                                     // shift amount (3 bits)
             shiftOffset = data & 0x07;
@@ -83,7 +83,7 @@ void IOPorts::write(uint8_t port, uint8_t data) {
         case 3:                                                     // sound bits
             prevOutPort3 = currOutPort3;
             currOutPort3 = data;
-            playNext.push({3, prevOutPort3, currOutPort3 });
+            soundEvents.push({cycle, 3, prevOutPort3, currOutPort3});
             break;
         case 4:                                                     // shift data
             shiftRegister = (shiftRegister >> 8) | (data << 8);
@@ -91,7 +91,7 @@ void IOPorts::write(uint8_t port, uint8_t data) {
         case 5:                                                     // sound bits
             prevOutPort5 = currOutPort5;
             currOutPort5 = data;
-            playNext.push({5, prevOutPort5, currOutPort5 });
+            soundEvents.push({cycle, 5, prevOutPort5, currOutPort5});
             break;
         default:
             break;
@@ -101,7 +101,27 @@ void IOPorts::write(uint8_t port, uint8_t data) {
 
 void IOPorts::setInPort1Bit(uint8_t bitNum, bool v) {
     if (v)
-        inPort1 |= (1 << bitNum);
+        inPort1.fetch_or(1 << bitNum, std::memory_order_relaxed);
     else
-        inPort1 &= ~(1 << bitNum);
+        inPort1.fetch_and(~(1 << bitNum), std::memory_order_relaxed);
+}
+
+void IOPorts::saveState(IOState& state) const {
+    state.inPort1 = inPort1.load(std::memory_order_relaxed);
+    state.prevOutPort3 = prevOutPort3;
+    state.currOutPort3 = currOutPort3;
+    state.prevOutPort5 = prevOutPort5;
+    state.currOutPort5 = currOutPort5;
+    state.shiftRegister = shiftRegister;
+    state.shiftOffset = shiftOffset;
+}
+
+void IOPorts::loadState(const IOState& state) {
+    inPort1.store(state.inPort1, std::memory_order_relaxed);
+    prevOutPort3 = state.prevOutPort3;
+    currOutPort3 = state.currOutPort3;
+    prevOutPort5 = state.prevOutPort5;
+    currOutPort5 = state.currOutPort5;
+    shiftRegister = state.shiftRegister;
+    shiftOffset = state.shiftOffset;
 }
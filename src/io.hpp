@@ -1,28 +1,50 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
-#include <queue>
-#include <tuple>
+
+#include "spscring.hpp"
+
+// A write to one of the sound ports, as the bits before and after it
+struct SoundEvent {
+    uint64_t cycle;     // Intel8080::cycleCount() at the OUT instruction
+    uint8_t  port;      // 3 or 5
+    uint8_t  previous;
+    uint8_t  current;
+};
+
+// Latches of the Space Invaders I/O board, as saved in snapshots
+struct IOState {
+    uint8_t  inPort1;
+    uint8_t  prevOutPort3, currOutPort3;
+    uint8_t  prevOutPort5, currOutPort5;
+    uint16_t shiftRegister;
+    uint8_t  shiftOffset;
+};
 
 class IOPorts {
 public:
+    static constexpr uint8_t IN_PORT1_IDLE = 1 << 3;   // No buttons pressed; bit 3 is always 1
+
     uint8_t read(uint8_t port);
-    void    write(uint8_t port, uint8_t data);
+    void    write(uint8_t port, uint8_t data, uint64_t cycle);    // cycle: CPU time of the write, for timestamping
 
-    void    setInPort1Bit(uint8_t bitNum, bool v);  // for Player 1 input handling
+    void    setInPort1Bit(uint8_t bitNum, bool v);  // for Player 1 input handling, safe from any thread
+    void    setInPort1(uint8_t value)               { inPort1.store(value, std::memory_order_relaxed); }
+    uint8_t inPort1Value() const                    { return inPort1.load(std::memory_order_relaxed); }
+    void    saveState(IOState& state) const;
+    void    loadState(const IOState& state);        // Pending sound events are kept
 
-    // Using a queue to keep track of changes between prev and
-    // curr outPorts. This was a hacky fix for some audio issues
-    // where there was sometimes delay and other times no
-    // sound being registered at all.
-    // Why does it work? It could be because it addresses
-    // a potential issue with concurrent modifications of the
-    // ports while running the emulation.
-    std::queue<std::tuple<uint8_t, uint8_t, uint8_t>> playNext;
+    // Sound port changes in the order the CPU made them, stamped with the
+    // cycle they happened at. Filled on the emulation thread and drained by
+    // the audio thread, so every change is heard even when several land
+    // between two audio updates. If nobody drains it, new events are dropped
+    // and counted in soundEvents.overflowCount().
+    SpscRing<SoundEvent, 256> soundEvents;
 
 private:
     // See http://computerarcheology.com/Arcade/SpaceInvaders/Hardware.html
-    uint8_t inPort1{1 << 3};                // Player 1 input register; bit 3 is always 1
+    std::atomic<uint8_t> inPort1{IN_PORT1_IDLE};    // Player 1 input register. Latched from the input thread
     uint8_t prevOutPort3, currOutPort3;     // consecutive bit changes correspond to particular sound cues
     uint8_t prevOutPort5, currOutPort5;     // consecutive bit changes correspond to particular sound cues
 
@@ -0,0 +1,358 @@
+#include "jit.hpp"
+#include "cpu.hpp"
+
+#include <cstring>
+#include <initializer_list>
+#include <iostream>
+
+#if I8080_JIT_AVAILABLE
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Little helpers for emitting x86-64 instructions
+static void emit8(std::vector<uint8_t>& code, uint8_t value) {
+    code.push_back(value);
+}
+
+static void emit32(std::vector<uint8_t>& code, uint32_t value) {
+    for (int i = 0; i < 4; i++) code.push_back((value >> (8 * i)) & 0xFF);
+}
+
+static void emit64(std::vector<uint8_t>& code, uint64_t value) {
+    for (int i = 0; i < 8; i++) code.push_back((value >> (8 * i)) & 0xFF);
+}
+
+// Emits a rel32 jump opcode and returns the offset of its displacement for patching
+static size_t emitJump(std::vector<uint8_t>& code, uint8_t condition) {
+    emit8(code, 0x0F); emit8(code, condition);
+    emit32(code, 0);
+    return code.size() - 4;
+}
+
+// Emits an instruction whose ModRM operand is [rbx + disp32], rbx holding the
+// Intel8080*: the opcode bytes, then ModRM with `reg` (a register or an
+// opcode extension), then the displacement
+static void emitRbx(std::vector<uint8_t>& code, std::initializer_list<uint8_t> opcode, uint8_t reg, int32_t disp) {
+    for (uint8_t byte : opcode) emit8(code, byte);
+    emit8(code, 0x83 | reg << 3);
+    emit32(code, static_cast<uint32_t>(disp));
+}
+
+static void emitBytes(std::vector<uint8_t>& code, std::initializer_list<uint8_t> bytes) {
+    for (uint8_t byte : bytes) emit8(code, byte);
+}
+
+constexpr uint8_t JLE = 0x8E;
+constexpr uint8_t JNE = 0x85;
+
+// x86 register numbers for ModRM
+constexpr uint8_t EAX = 0, ECX = 1, EDX = 2, ESI = 6, EDI = 7;
+
+// 8080 register and flag positions (Intel8080::Register8, FLAGS8080)
+constexpr int32_t REG_A = 7, REG_FLAGS = 8;
+constexpr uint8_t FLAG_CY = 0x01, FLAG_AC = 0x10;
+
+Jit::Jit(const std::array<Thunk, 256>& thunks, const JitLayout& layout)
+        : thunks(thunks), layout(layout), entries(RAM_SIZE), arena(nullptr), arenaUsed() {
+#if I8080_JIT_AVAILABLE
+    void* memory = mmap(nullptr, ARENA_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+        std::cerr << "JIT: failed to map code arena, falling back to the interpreter." << std::endl;
+    else
+        arena = static_cast<uint8_t*>(memory);
+#endif
+}
+
+Jit::~Jit() {
+#if I8080_JIT_AVAILABLE
+    if (arena) munmap(arena, ARENA_SIZE);
+#endif
+}
+
+Jit::Code Jit::find(uint16_t pc, const Memory& memory) {
+    Entry& entry = entries[pc];
+    if (!entry.code) return nullptr;
+
+    // The block's bytes were written since translation: drop it and let it get hot again
+    if (memory.pageVersion(entry.firstPage) != entry.versions[0] ||
+        memory.pageVersion(entry.lastPage)  != entry.versions[1]) {
+        entry.code = nullptr;
+        entry.hits = 0;
+        return nullptr;
+    }
+    return entry.code;
+}
+
+// Drops every translation and recycles the arena
+void Jit::flush() {
+    for (Entry& entry : entries) {
+        entry.code = nullptr;
+        entry.hits = 0;
+    }
+    arenaUsed = 0;
+}
+
+void Jit::compile(const Block& block, const DecodedOp* ops, const Memory& memory) {
+#if I8080_JIT_AVAILABLE
+    if (!arena) return;
+
+    std::vector<uint8_t>& code = buffer;
+    std::vector<size_t> exits;
+    code.clear();
+
+    // push rbx; mov rbx, rdi          (rbx holds the Intel8080* across thunk calls)
+    emit8(code, 0x53);
+    emit8(code, 0x48); emit8(code, 0x89); emit8(code, 0xFB);
+
+    for (int i = 0; i < block.count; i++) {
+        const DecodedOp& op = ops[i];
+
+        if (emitInline(code, op)) {
+            // mov word [rbx + pc], next; sub dword [rbx + cycles], cost; jle exit
+            emitRbx(code, {0x66, 0xC7}, 0, layout.pc);
+            uint16_t next = op.pc + OPCODES[op.opcode].length;
+            emit8(code, next & 0xFF); emit8(code, next >> 8);
+            emitRbx(code, {0x83}, 5, layout.cycles);
+            emit8(code, op.cycles);
+            exits.push_back(emitJump(code, JLE));
+            continue;
+        }
+
+        // mov rdi, rbx; mov esi, pc + 1; mov rax, thunk; call rax
+        emit8(code, 0x48); emit8(code, 0x89); emit8(code, 0xDF);
+        emit8(code, 0xBE); emit32(code, (uint16_t) (op.pc + 1));
+        emit8(code, 0x48); emit8(code, 0xB8); emit64(code, reinterpret_cast<uint64_t>(thunks[op.opcode]));
+        emit8(code, 0xFF); emit8(code, 0xD0);
+
+        // test eax, eax; jle exit         (cycle budget exhausted)
+        emit8(code, 0x85); emit8(code, 0xC0);
+        exits.push_back(emitJump(code, JLE));
+
+        // A store may have hit this block: leave if either page's write counter moved
+        if (op.writesMemory) {
+            for (int p = 0; p < 2; p++) {
+                uint8_t page = p == 0 ? block.firstPage : block.lastPage;
+                // mov rax, &pageVersion; cmp dword [rax], version; jne exit
+                emit8(code, 0x48); emit8(code, 0xB8); emit64(code, reinterpret_cast<uint64_t>(memory.pageVersionAddress(page)));
+                emit8(code, 0x81); emit8(code, 0x38); emit32(code, block.versions[p]);
+                exits.push_back(emitJump(code, JNE));
+            }
+        }
+    }
+
+    // exit: pop rbx; ret
+    size_t exit = code.size();
+    emit8(code, 0x5B);
+    emit8(code, 0xC3);
+    for (size_t at : exits) {
+        int32_t displacement = static_cast<int32_t>(exit - (at + 4));
+        memcpy(&code[at], &displacement, 4);
+    }
+
+    if (arenaUsed + code.size() > ARENA_SIZE) flush();
+
+    // Keep the arena W^X: only the pages the new code lands on are made
+    // writable, and only while copying it in
+    static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t first = arenaUsed & ~(pageSize - 1);
+    size_t end = (arenaUsed + code.size() + pageSize - 1) & ~(pageSize - 1);
+    if (mprotect(arena + first, end - first, PROT_READ | PROT_WRITE) != 0) return;
+    memcpy(arena + arenaUsed, code.data(), code.size());
+    if (mprotect(arena + first, end - first, PROT_READ | PROT_EXEC) != 0) return;
+
+    Entry& entry = entries[block.start];
+    entry.code = reinterpret_cast<Code>(arena + arenaUsed);
+    entry.firstPage = block.firstPage;
+    entry.lastPage = block.lastPage;
+    entry.versions[0] = block.versions[0];
+    entry.versions[1] = block.versions[1];
+    arenaUsed += (code.size() + 15) & ~size_t(15);
+#else
+    (void) block; (void) ops; (void) memory;
+#endif
+}
+
+// Emits the body of an inlinable opcode (see Intel8080::inlinable) operating
+// on the CPU's fields through rbx, without the pc and cycle updates. Each case
+// reproduces the handler's helper exactly; the comments give the 8080-level
+// meaning. AC and CY are bits 4 and 0 of FLAGS; Z, S and P are left lazy in
+// zspResult like SetZSP does.
+bool Jit::emitInline(std::vector<uint8_t>& code, const DecodedOp& op) const {
+    if (!Intel8080::inlinable(op.opcode)) return false;
+    const OpcodeInfo& info = OPCODES[op.opcode];
+    const int32_t reg = layout.reg8;
+    const int32_t flags = reg + REG_FLAGS;
+    const uint8_t r = info.values[0];
+    const uint16_t imm = op.imm;
+
+    // Stores the result in dl (or al) to `dest` and into zspResult, zspLazy = true
+    auto storeResult = [&](uint8_t source, int32_t dest) {
+        if (dest >= 0) emitRbx(code, {0x88}, source, dest);             // mov [dest], dl
+        emitRbx(code, {0x88}, source, layout.zspResult);                // mov [zspResult], dl
+        emitRbx(code, {0xC6}, 0, layout.zspLazy); emit8(code, 1);       // mov byte [zspLazy], 1
+    };
+    // FLAGS = (FLAGS & ~mask) | sil
+    auto mergeFlags = [&](uint8_t mask) {
+        emitRbx(code, {0x80}, 4, flags); emit8(code, static_cast<uint8_t>(~mask));  // and byte [flags], ~mask
+        emitRbx(code, {0x40, 0x08}, ESI, flags);                                     // or [flags], sil
+    };
+    // ecx = the ALU operand: register values[0] or the immediate
+    auto loadOperand = [&] {
+        if (info.operands[0] == Operand::Imm8) {
+            emit8(code, 0xB9); emit32(code, imm);                       // mov ecx, imm
+        } else {
+            emitRbx(code, {0x0F, 0xB6}, ECX, reg + r);                  // movzx ecx, byte [reg]
+        }
+        emitRbx(code, {0x0F, 0xB6}, EAX, reg + REG_A);                  // movzx eax, byte [A]
+    };
+    // ecx += CY
+    auto addCarry = [&] {
+        emitRbx(code, {0x0F, 0xB6}, EDI, flags);                        // movzx edi, byte [flags]
+        emitBytes(code, {0x83, 0xE7, 0x01});                            // and edi, 1
+        emitBytes(code, {0x01, 0xF9});                                  // add ecx, edi
+    };
+    // esi = bit 4 of eax ^ ecx ^ edx, the carry out of bit 3
+    auto halfCarry = [&] {
+        emitBytes(code, {0x89, 0xC6});                                  // mov esi, eax
+        emitBytes(code, {0x31, 0xCE});                                  // xor esi, ecx
+        emitBytes(code, {0x31, 0xD6});                                  // xor esi, edx
+        emitBytes(code, {0x83, 0xE6, FLAG_AC});                         // and esi, 10h
+    };
+
+    switch (info.mnemonic) {
+        case Mnemonic::NOP:
+            return true;
+
+        case Mnemonic::MOV:                                             // d = s
+            emitRbx(code, {0x0F, 0xB6}, EAX, reg + info.values[1]);     // movzx eax, byte [s]
+            emitRbx(code, {0x88}, EAX, reg + r);                        // mov [d], al
+            return true;
+
+        case Mnemonic::MVI:                                             // d = imm
+            emitRbx(code, {0xC6}, 0, reg + r); emit8(code, imm & 0xFF); // mov byte [d], imm
+            return true;
+
+        // Pairs are stored high byte first (B, C), the other way round from x86
+        case Mnemonic::LXI:
+            if (r == 3) {
+                emitRbx(code, {0x66, 0xC7}, 0, layout.sp);              // mov word [sp], imm
+                emit8(code, imm & 0xFF); emit8(code, imm >> 8);
+            } else {
+                emitRbx(code, {0x66, 0xC7}, 0, reg + 2 * r);            // mov word [pair], bswap(imm)
+                emit8(code, imm >> 8); emit8(code, imm & 0xFF);
+            }
+            return true;
+
+        case Mnemonic::INX:
+        case Mnemonic::DCX: {
+            uint8_t direction = info.mnemonic == Mnemonic::INX ? 0 : 1;
+            if (r == 3) {
+                emitRbx(code, {0x66, 0xFF}, direction, layout.sp);      // inc/dec word [sp]
+            } else {
+                emitRbx(code, {0x0F, 0xB7}, EAX, reg + 2 * r);          // movzx eax, word [pair]
+                emitBytes(code, {0x66, 0xC1, 0xC0, 0x08});              // rol ax, 8
+                emitBytes(code, {0xFF, static_cast<uint8_t>(0xC0 | direction << 3)});  // inc/dec eax
+                emitBytes(code, {0x66, 0xC1, 0xC0, 0x08});              // rol ax, 8
+                emitRbx(code, {0x66, 0x89}, EAX, reg + 2 * r);          // mov [pair], ax
+            }
+            return true;
+        }
+
+        case Mnemonic::INR:                                             // AC = carry out of bit 3
+            emitRbx(code, {0x0F, 0xB6}, EAX, reg + r);                  // movzx eax, byte [r]
+            emitBytes(code, {0x8D, 0x50, 0x01});                        // lea edx, [rax + 1]
+            emitBytes(code, {0x89, 0xC6});                              // mov esi, eax
+            emitBytes(code, {0x31, 0xD6});                              // xor esi, edx
+            emitBytes(code, {0x83, 0xE6, FLAG_AC});                     // and esi, 10h
+            mergeFlags(FLAG_AC);
+            storeResult(EDX, reg + r);
+            return true;
+
+        case Mnemonic::DCR:                                             // AC = low nibble was 0
+            emitRbx(code, {0x0F, 0xB6}, EAX, reg + r);                  // movzx eax, byte [r]
+            emitBytes(code, {0x8D, 0x50, 0xFF});                        // lea edx, [rax - 1]
+            emitBytes(code, {0x31, 0xF6});                              // xor esi, esi
+            emitBytes(code, {0xA8, 0x0F});                              // test al, 0Fh
+            emitBytes(code, {0x40, 0x0F, 0x94, 0xC6});                  // sete sil
+            emitBytes(code, {0xC1, 0xE6, 0x04});                        // shl esi, 4
+            mergeFlags(FLAG_AC);
+            storeResult(EDX, reg + r);
+            return true;
+
+        case Mnemonic::ADD: case Mnemonic::ADI:
+        case Mnemonic::ADC: case Mnemonic::ACI:                         // CY = bit 8 of the sum
+            loadOperand();
+            if (info.mnemonic == Mnemonic::ADC || info.mnemonic == Mnemonic::ACI) addCarry();
+            emitBytes(code, {0x8D, 0x14, 0x08});                        // lea edx, [rax + rcx]
+            halfCarry();
+            emitBytes(code, {0x89, 0xD7});                              // mov edi, edx
+            emitBytes(code, {0xC1, 0xEF, 0x08});                        // shr edi, 8
+            emitBytes(code, {0x09, 0xFE});                              // or esi, edi
+            mergeFlags(FLAG_AC | FLAG_CY);
+            storeResult(EDX, reg + REG_A);
+            return true;
+
+        case Mnemonic::SUB: case Mnemonic::SUI:
+        case Mnemonic::SBB: case Mnemonic::SBI:
+        case Mnemonic::CMP: case Mnemonic::CPI: {                       // CY = the byte subtracted exceeds A
+            loadOperand();
+            if (info.mnemonic == Mnemonic::SBB || info.mnemonic == Mnemonic::SBI) addCarry();
+            emitBytes(code, {0x0F, 0xB6, 0xC9});                        // movzx ecx, cl
+            emitBytes(code, {0x89, 0xC2});                              // mov edx, eax
+            emitBytes(code, {0x29, 0xCA});                              // sub edx, ecx
+            halfCarry();
+            emitBytes(code, {0x89, 0xD7});                              // mov edi, edx
+            emitBytes(code, {0xC1, 0xEF, 0x1F});                        // shr edi, 31
+            emitBytes(code, {0x09, 0xFE});                              // or esi, edi
+            mergeFlags(FLAG_AC | FLAG_CY);
+            bool compare = info.mnemonic == Mnemonic::CMP || info.mnemonic == Mnemonic::CPI;
+            storeResult(EDX, compare ? -1 : reg + REG_A);
+            return true;
+        }
+
+        case Mnemonic::ANA: case Mnemonic::ANI:                         // AC = bit 7 of A | value, CY = 0
+            loadOperand();
+            emitBytes(code, {0x89, 0xC6});                              // mov esi, eax
+            emitBytes(code, {0x09, 0xCE});                              // or esi, ecx
+            emitBytes(code, {0xC1, 0xEE, 0x03});                        // shr esi, 3
+            emitBytes(code, {0x83, 0xE6, FLAG_AC});                     // and esi, 10h
+            mergeFlags(FLAG_AC | FLAG_CY);
+            emitBytes(code, {0x21, 0xC8});                              // and eax, ecx
+            storeResult(EAX, reg + REG_A);
+            return true;
+
+        case Mnemonic::XRA: case Mnemonic::XRI:
+        case Mnemonic::ORA: case Mnemonic::ORI:                         // AC = CY = 0
+            loadOperand();
+            emitRbx(code, {0x80}, 4, flags); emit8(code, static_cast<uint8_t>(~(FLAG_AC | FLAG_CY)));  // and byte [flags], ~11h
+            if (info.mnemonic == Mnemonic::XRA || info.mnemonic == Mnemonic::XRI)
+                emitBytes(code, {0x31, 0xC8});                          // xor eax, ecx
+            else
+                emitBytes(code, {0x09, 0xC8});                          // or eax, ecx
+            storeResult(EAX, reg + REG_A);
+            return true;
+
+        case Mnemonic::CMA:
+            emitRbx(code, {0xF6}, 2, reg + REG_A);                      // not byte [A]
+            return true;
+
+        case Mnemonic::CMC:
+            emitRbx(code, {0x80}, 6, flags); emit8(code, FLAG_CY);      // xor byte [flags], 1
+            return true;
+
+        case Mnemonic::STC:
+            emitRbx(code, {0x80}, 1, flags); emit8(code, FLAG_CY);      // or byte [flags], 1
+            return true;
+
+        case Mnemonic::XCHG:                                            // DE <-> HL
+            emitRbx(code, {0x0F, 0xB7}, EAX, reg + 2);                  // movzx eax, word [D]
+            emitRbx(code, {0x0F, 0xB7}, ECX, reg + 4);                  // movzx ecx, word [H]
+            emitRbx(code, {0x66, 0x89}, ECX, reg + 2);                  // mov [D], cx
+            emitRbx(code, {0x66, 0x89}, EAX, reg + 4);                  // mov [H], ax
+            return true;
+
+        default:
+            return false;
+    }
+}
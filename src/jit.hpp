@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "blockcache.hpp"
+#include "memory.hpp"
+
+class Intel8080;
+
+// Where the CPU state that translated code reads and writes directly lives,
+// as byte offsets from the start of the Intel8080
+struct JitLayout {
+    int32_t reg8;           // uint8_t[9]: B, C, D, E, H, L, M, A, FLAGS
+    int32_t sp;             // uint16_t
+    int32_t pc;             // uint16_t
+    int32_t cycles;         // int32_t
+    int32_t zspResult;      // uint8_t
+    int32_t zspLazy;        // bool
+};
+
+// The JIT emits x86-64 System V machine code and needs mmap/mprotect
+#if defined(I8080_JIT) && defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define I8080_JIT_AVAILABLE 1
+#else
+#define I8080_JIT_AVAILABLE 0
+#endif
+
+// Translates hot basic blocks into native x86-64 code.
+//
+// The generated code is call-threaded: for each 8080 instruction it calls a
+// per-opcode thunk (Intel8080::opThunk<OP>) with the instruction's pc baked
+// in as an immediate. Each thunk is the interpreter handler inlined for a
+// constant opcode, so the 8080 semantics stay in opcodes.cpp and the cycle
+// costs in OPCODES. What the translation removes is instruction fetch, decode
+// and the dispatch jump. The opcodes Intel8080::inlinable accepts (register
+// moves and ALU ops, immediates, register pairs) are emitted as x86 instead,
+// working on the CPU's fields in place (see JitLayout) with the operand as
+// an immediate; they must match the handlers' helpers bit for bit, flags
+// included. After every instruction the remaining cycle budget is tested,
+// exactly like the interpreter loop. Stores are followed by a check of the
+// block's page write counters, so self-modifying code leaves native code
+// immediately.
+class Jit {
+public:
+    using Thunk = int  (*)(Intel8080* cpu, uint32_t pc);    // Runs one opcode, returns remaining cycles
+    using Code  = void (*)(Intel8080* cpu);                 // A translated block
+
+    static constexpr uint16_t HOT_THRESHOLD = 16;           // Interpreted entries before a block is translated
+
+    Jit(const std::array<Thunk, 256>& thunks, const JitLayout& layout);
+    ~Jit();
+    Jit(const Jit&) = delete;
+    Jit& operator=(const Jit&) = delete;
+
+    Code find(uint16_t pc, const Memory& memory);           // Native code for the block at pc, if still valid
+    bool isHot(uint16_t pc)                                 { return ++entries[pc].hits == HOT_THRESHOLD; }
+    void compile(const Block& block, const DecodedOp* ops, const Memory& memory);
+
+    static constexpr bool available()                       { return I8080_JIT_AVAILABLE; }
+
+private:
+    struct Entry {
+        Code     code;
+        uint32_t versions[2];   // Memory page versions the translation was made from
+        uint8_t  firstPage;
+        uint8_t  lastPage;
+        uint16_t hits;
+    };
+
+    static constexpr size_t ARENA_SIZE = 8 << 20;
+
+    const std::array<Thunk, 256>& thunks;
+    JitLayout            layout;
+    std::vector<Entry>   entries;   // Indexed by block start address
+    std::vector<uint8_t> buffer;    // Code being emitted
+    uint8_t* arena;                 // Executable memory
+    size_t   arenaUsed;
+
+    void flush();
+    bool emitInline(std::vector<uint8_t>& code, const DecodedOp& op) const;
+};
@@ -0,0 +1,173 @@
+#include "machine.hpp"
+#include "serialize.hpp"
+
+#include <fstream>
+#include <iostream>
+
+Machine::Machine() {
+    // Address lines A13-A0 are decoded and A15 is ignored, so 0x0000-0x7FFF
+    // repeats at 0x8000. Within it: program ROM, RAM, a second ROM area (unused
+    // by Space Invaders, reads as zero) and a mirror of the RAM. ROM writes
+    // are dropped and show up in Memory::illegalWrites(); the game itself
+    // makes a few, when shots drawn near the top of the screen run past the
+    // end of video RAM into 0x4000-0x41FF.
+    // Source: MAME, mw8080bw.cpp (main_map)
+    Memory& memory = *cpu.memory;
+    for (uint32_t base = 0; base < RAM_SIZE; base += 0x8000) {
+        memory.map(base + ROM_START, base + RAM_START - 1, Memory::Access::ReadOnly, ROM_START);
+        memory.map(base + RAM_START, base + RAM_END - 1, Memory::Access::ReadWrite, RAM_START);
+        memory.map(base + 0x4000, base + 0x5FFF, Memory::Access::ReadOnly, 0x4000);
+        memory.map(base + 0x6000, base + 0x7FFF, Memory::Access::ReadWrite, RAM_START);
+    }
+
+    midScreenEvent = scheduler.schedule(HALF_FRAME_CYCLES, [this](uint64_t) {
+        cpu.interrupt(1);   // half-screen interrupt (RST 1)
+    }, FRAME_CYCLES);
+    vblankEvent = scheduler.schedule(FRAME_CYCLES, [this](uint64_t) {
+        cpu.interrupt(2);   // full-screen interrupt (RST 2)
+        frames++;
+    }, FRAME_CYCLES);
+}
+
+bool Machine::load(const std::string& romPath) {
+    return cpu.load(romPath, ROM_START);
+}
+
+bool Machine::load(const std::vector<uint8_t>& rom) {
+    return cpu.memory->load(rom.data(), rom.size(), ROM_START);
+}
+
+void Machine::runFrame() {
+    NullTrace trace;
+    runFrame(trace);
+}
+
+void Machine::discardSounds() {
+    SoundEvent event;
+    while (cpu.ioPorts->soundEvents.pop(event)) {}
+}
+
+void Machine::captureVideo(VideoFrame& video) const {
+    std::copy(videoRam(), videoRam() + VRAM_BYTES, video.vram.begin());
+    for (uint16_t strip = 0; strip < SCREEN_STRIPS; strip++)
+        video.stripVersions[strip] = cpu.memory->pageVersion((VRAM_START >> 8) + strip);
+    video.frame = frames;
+}
+
+void Machine::save(Snapshot& snapshot) const {
+    cpu.saveState(snapshot.cpu);
+    cpu.ioPorts->saveState(snapshot.io);
+    snapshot.frames = frames;
+    std::copy(ram(), ram() + RAM_BYTES, snapshot.ram.begin());
+}
+
+// First time after `now` that an event recurring every FRAME_CYCLES from `offset` is due
+static uint64_t nextOccurrence(uint64_t now, uint64_t offset) {
+    return now < offset ? offset : ((now - offset) / FRAME_CYCLES + 1) * FRAME_CYCLES + offset;
+}
+
+void Machine::restore(const Snapshot& snapshot) {
+    cpu.loadState(snapshot.cpu);
+    cpu.ioPorts->loadState(snapshot.io);
+    frames = snapshot.frames;
+
+    // Goes through Memory::load so that the page versions move on: code
+    // decoded from the old RAM is dropped and every VRAM strip gets redrawn
+    cpu.memory->load(snapshot.ram.data(), RAM_BYTES, RAM_START);
+
+    // Events at or before the snapshot's cycle had already fired when it was taken
+    uint64_t now = cpu.cycleCount();
+    scheduler.reschedule(midScreenEvent, nextOccurrence(now, HALF_FRAME_CYCLES));
+    scheduler.reschedule(vblankEvent, nextOccurrence(now, FRAME_CYCLES));
+}
+
+// Snapshot files are little-endian, field by field:
+//   "I8080SNP", u32 version, u64 ROM hash,
+//   B C D E H L M A FLAGS, u16 SP, u16 PC, u8 INTE, i32 cycles, u64 cycleEnd,
+//   u8 port 1, u8 port 3 previous/current, u8 port 5 previous/current, u16 shift register, u8 shift offset,
+//   u64 frames, 8 KB RAM (0x2000-0x3FFF)
+constexpr char SNAPSHOT_MAGIC[8] = {'I', '8', '0', '8', '0', 'S', 'N', 'P'};
+
+bool Machine::saveState(const std::string& filePath) const {
+    Snapshot snapshot;
+    save(snapshot);
+
+    std::vector<uint8_t> out(SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + sizeof(SNAPSHOT_MAGIC));
+    putLE(out, SNAPSHOT_VERSION);
+    putLE(out, romHash());
+    for (uint8_t r : snapshot.cpu.reg8) putLE(out, r);
+    putLE(out, snapshot.cpu.sp);
+    putLE(out, snapshot.cpu.pc);
+    putLE(out, snapshot.cpu.intEnable);
+    putLE(out, snapshot.cpu.cycles);
+    putLE(out, snapshot.cpu.cycleEnd);
+    putLE(out, snapshot.io.inPort1);
+    putLE(out, snapshot.io.prevOutPort3);
+    putLE(out, snapshot.io.currOutPort3);
+    putLE(out, snapshot.io.prevOutPort5);
+    putLE(out, snapshot.io.currOutPort5);
+    putLE(out, snapshot.io.shiftRegister);
+    putLE(out, snapshot.io.shiftOffset);
+    putLE(out, snapshot.frames);
+    out.insert(out.end(), snapshot.ram.begin(), snapshot.ram.end());
+
+    std::ofstream file(filePath, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+    if (!file) {
+        std::cerr << "Failed to write snapshot: " << filePath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Machine::loadState(const std::string& filePath) {
+    std::vector<uint8_t> in;
+    if (!readFile(filePath, in)) return false;
+
+    if (in.size() < sizeof(SNAPSHOT_MAGIC) || !std::equal(SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + sizeof(SNAPSHOT_MAGIC), in.begin())) {
+        std::cerr << "Not a snapshot file: " << filePath << std::endl;
+        return false;
+    }
+
+    size_t at = sizeof(SNAPSHOT_MAGIC);
+    uint32_t version = 0;
+    uint64_t hash = 0;
+    if (!getLE(in, at, version) || version != SNAPSHOT_VERSION) {
+        std::cerr << "Unsupported snapshot version " << version << ": " << filePath << std::endl;
+        return false;
+    }
+    if (!getLE(in, at, hash) || hash != romHash()) {
+        std::cerr << "Snapshot was taken with a different ROM: " << filePath << std::endl;
+        return false;
+    }
+
+    Snapshot snapshot;
+    bool ok = true;
+    for (uint8_t& r : snapshot.cpu.reg8) ok = ok && getLE(in, at, r);
+    ok = ok && getLE(in, at, snapshot.cpu.sp) && getLE(in, at, snapshot.cpu.pc) && getLE(in, at, snapshot.cpu.intEnable) &&
+         getLE(in, at, snapshot.cpu.cycles) && getLE(in, at, snapshot.cpu.cycleEnd) &&
+         getLE(in, at, snapshot.io.inPort1) && getLE(in, at, snapshot.io.prevOutPort3) && getLE(in, at, snapshot.io.currOutPort3) &&
+         getLE(in, at, snapshot.io.prevOutPort5) && getLE(in, at, snapshot.io.currOutPort5) &&
+         getLE(in, at, snapshot.io.shiftRegister) && getLE(in, at, snapshot.io.shiftOffset) &&
+         getLE(in, at, snapshot.frames);
+    if (!ok || in.size() - at != RAM_BYTES) {
+        std::cerr << "Truncated snapshot file: " << filePath << std::endl;
+        return false;
+    }
+    std::copy(in.begin() + at, in.end(), snapshot.ram.begin());
+
+    restore(snapshot);
+    return true;
+}
+
+uint64_t Machine::romHash() const {
+    return fnv1a(cpu.memory->data() + ROM_START, RAM_START - ROM_START);
+}
+
+uint64_t Machine::videoRamHash() const {
+    return fnv1a(videoRam(), VRAM_BYTES);
+}
+
+uint64_t Machine::ramHash() const {
+    return fnv1a(ram(), RAM_BYTES);
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "cpu.hpp"
+#include "framebuffer.hpp"
+#include "hash.hpp"
+#include "scheduler.hpp"
+
+// Space Invaders memory map.
+// Source: http://computerarcheology.com/Arcade/SpaceInvaders/Hardware.html
+constexpr uint16_t ROM_START  = 0x0000;     // 8 KB program ROM
+constexpr uint16_t RAM_START  = 0x2000;     // 1 KB work RAM
+constexpr uint16_t VRAM_START = 0x2400;     // 7 KB video RAM
+constexpr uint16_t RAM_END    = 0x4000;
+constexpr uint16_t VRAM_BYTES = RAM_END - VRAM_START;
+constexpr uint16_t RAM_BYTES  = RAM_END - RAM_START;
+
+// The CPU runs at 2 MHz and the screen refreshes at 60 Hz. The hardware raises
+// RST 1 when the beam reaches the middle of the screen and RST 2 at VBLANK,
+// so each frame is split into two halves of 2,000,000 / 60 / 2 ≈ 16,666 cycles.
+constexpr int      HALF_FRAME_CYCLES = 16666;
+constexpr uint64_t FRAME_CYCLES      = 2 * HALF_FRAME_CYCLES;
+
+// Player 1 input bits on port 1 (see IOPorts::read)
+enum class Button : uint8_t { Coin = 0, P2Start = 1, P1Start = 2, Fire = 4, Left = 5, Right = 6 };
+
+// A copy of the screen for handing to another thread
+struct VideoFrame {
+    std::array<uint8_t, VRAM_BYTES>     vram;
+    std::array<uint32_t, SCREEN_STRIPS> stripVersions;  // Memory::pageVersion of each strip's page (see Display)
+    uint64_t                            frame;          // Machine::frameCount when captured
+};
+
+// Everything needed to resume a Machine: CPU registers, I/O latches and the
+// 8 KB of RAM. The ROM is left out, so a snapshot only restores into a
+// machine running the same program (the file format checks this).
+struct Snapshot {
+    CpuState cpu;
+    IOState  io;
+    uint64_t frames;
+    std::array<uint8_t, RAM_BYTES> ram;
+};
+
+constexpr uint32_t SNAPSHOT_VERSION = 1;   // Bump whenever the file layout changes
+
+// The Space Invaders board without any frontend: CPU, memory and I/O ports,
+// stepped one video frame at a time. Used by the headless runner and anything
+// else that needs to emulate without a window or audio device.
+//
+// Time is kept as an absolute cycle count. The mid-screen (RST 1) and VBLANK
+// (RST 2) interrupts are Scheduler events at fixed timestamps, frame n's at
+// n * FRAME_CYCLES + HALF_FRAME_CYCLES and (n + 1) * FRAME_CYCLES, so cycles
+// an instruction runs past an interrupt are carried over instead of lost.
+class Machine {
+public:
+    Machine();
+    Machine(const Machine&) = delete;                       // Scheduled events point back at this machine
+    Machine& operator=(const Machine&) = delete;
+
+    bool load(const std::string& romPath);                  // Load the 8 KB program ROM at 0x0000
+    bool load(const std::vector<uint8_t>& rom);             // Same, from an image already in memory
+    void runFrame();                                        // Emulate up to and including the next VBLANK
+    template <typename Trace>
+    void runFrame(Trace& trace);
+    template <typename Trace>
+    void runUntil(uint64_t cycle, Trace& trace);            // Emulate up to the first instruction boundary at or past `cycle`
+    void setButton(Button button, bool pressed)             { cpu.ioPorts->setInPort1Bit(static_cast<uint8_t>(button), pressed); }
+    void setInputs(uint8_t port1)                           { cpu.ioPorts->setInPort1(port1); }     // All buttons at once
+    uint8_t inputs() const                                  { return cpu.ioPorts->inPort1Value(); }
+    void discardSounds();                                   // Without audio nobody drains the sound queue
+    void captureVideo(VideoFrame& video) const;
+
+    void save(Snapshot& snapshot) const;                    // In-memory snapshot, copies only RAM
+    void restore(const Snapshot& snapshot);
+    bool saveState(const std::string& filePath) const;      // Snapshot to/from a file
+    bool loadState(const std::string& filePath);
+
+    const uint8_t* videoRam() const                         { return cpu.memory->data() + VRAM_START; }
+    const uint8_t* ram() const                              { return cpu.memory->data() + RAM_START; }
+    uint64_t       videoRamHash() const;                    // FNV-1a hash of video RAM
+    uint64_t       ramHash() const;                         // FNV-1a hash of work + video RAM
+    uint64_t       frameCount() const                       { return frames; }
+    uint64_t       cycleCount() const                       { return cpu.cycleCount(); }
+    uint64_t       romHash() const;                         // FNV-1a hash of the program ROM
+
+    Intel8080 cpu;
+    Scheduler scheduler;                                    // Add further timed events here
+
+private:
+    uint64_t frames = 0;    // VBLANKs so far
+    Scheduler::EventId midScreenEvent;
+    Scheduler::EventId vblankEvent;
+};
+
+template <typename Trace>
+void Machine::runFrame(Trace& trace) {
+    runUntil((frames + 1) * FRAME_CYCLES, trace);
+}
+
+template <typename Trace>
+void Machine::runUntil(uint64_t cycle, Trace& trace) {
+    while (cpu.cycleCount() < cycle) {
+        // Run to the next event or the target, whichever comes first. After an
+        // overshoot the next event may already be due, then it just fires.
+        uint64_t now = cpu.cycleCount();
+        uint64_t stop = std::min(cycle, scheduler.nextEventTime());
+        if (stop > now)
+            cpu.execute(static_cast<int>(std::min<uint64_t>(stop - now, INT32_MAX)), trace);
+        scheduler.runDue(cpu.cycleCount());
+    }
+}
@@ -0,0 +1,46 @@
+#include "machinepool.hpp"
+
+#include <algorithm>
+
+MachinePool::MachinePool(size_t machineCount, unsigned threadCount)
+        : threads(static_cast<unsigned>(std::min<size_t>(std::max(threadCount, 1u), std::max<size_t>(machineCount, 1)))) {
+    machines.reserve(machineCount);
+    for (size_t i = 0; i < machineCount; i++)
+        machines.push_back(std::make_unique<Machine>());
+}
+
+bool MachinePool::load(const std::string& romPath) {
+    std::vector<uint8_t> rom;
+    return readFile(romPath, rom) && load(rom);
+}
+
+bool MachinePool::load(const std::vector<uint8_t>& rom) {
+    for (auto& machine : machines)
+        if (!machine->load(rom)) return false;
+    return true;
+}
+
+void MachinePool::setDispatch(Intel8080::Dispatch dispatch) {
+    for (auto& machine : machines)
+        machine->cpu.setDispatch(dispatch);
+}
+
+void MachinePool::setIdleSkip(bool enabled) {
+    for (auto& machine : machines)
+        machine->cpu.setIdleSkip(enabled);
+}
+
+void MachinePool::runFrames(int frames) {
+    // Around eight chunks per thread leaves enough slack to steal without
+    // paying for a lock per machine
+    size_t grain = std::max<size_t>(1, machines.size() / (threads.threadCount() * 8));
+
+    threads.parallelFor(machines.size(), grain, [this, frames](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            Machine& machine = *machines[i];
+            for (int frame = 0; frame < frames; frame++)
+                machine.runFrame();
+            machine.discardSounds();
+        }
+    });
+}
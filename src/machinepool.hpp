@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "machine.hpp"
+#include "threadpool.hpp"
+
+// N independent Space Invaders machines stepped in lockstep across a
+// work-stealing thread pool. Every machine owns its CPU, memory and I/O
+// ports, so instances share nothing but the (read-only) ROM image they were
+// loaded from. Between calls to runFrames() the caller may freely read each
+// machine's framebuffer/RAM and set its inputs, e.g. one RL environment per
+// machine.
+class MachinePool {
+public:
+    explicit MachinePool(size_t machineCount, unsigned threadCount = std::thread::hardware_concurrency());
+
+    bool load(const std::string& romPath);                  // Read the ROM once and load it into every machine
+    bool load(const std::vector<uint8_t>& rom);             // Same, from an image already in memory
+    void setDispatch(Intel8080::Dispatch dispatch);         // Select the execution engine of every machine
+    void setIdleSkip(bool enabled);                         // See Intel8080::setIdleSkip
+    void runFrames(int frames = 1);                         // Advance every machine, returns when all are done
+
+    size_t         size() const                             { return machines.size(); }
+    Machine&       machine(size_t i)                        { return *machines[i]; }
+    const Machine& machine(size_t i) const                  { return *machines[i]; }
+    const uint8_t* videoRam(size_t i) const                 { return machines[i]->videoRam(); }
+    const uint8_t* ram(size_t i) const                      { return machines[i]->ram(); }
+    unsigned       threadCount() const                      { return threads.threadCount(); }
+
+private:
+    // Machines are heap-allocated one by one so two workers never write to
+    // the same cache line
+    std::vector<std::unique_ptr<Machine>> machines;
+    ThreadPool threads;
+};
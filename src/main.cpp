@@ -1,8 +1,21 @@
-
 #include "platform.hpp"
 
-int main() {
+#include <iostream>
+#include <string>
+
+// Usage: Intel_8080 [--record PATH | --replay PATH]
+//   --record PATH   Record the session's inputs to a movie file, written on exit
+//   --replay PATH   Play a movie back, checking every frame against its recording
+int main(int argc, char* argv[]) {
     Platform* platform = new Platform();
+    if (argc == 3 && std::string(argv[1]) == "--record") {
+        platform->recordMovie(argv[2]);
+    } else if (argc == 3 && std::string(argv[1]) == "--replay") {
+        if (!platform->replayMovie(argv[2])) return 1;
+    } else if (argc != 1) {
+        std::cerr << "Usage: Intel_8080 [--record PATH | --replay PATH]" << std::endl;
+        return 1;
+    }
     platform->run();
     return 0;
 }
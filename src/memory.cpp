@@ -1,8 +1,9 @@
 #include "memory.hpp"
+#include <algorithm>
 #include <iostream>
 #include <string>
 
-bool Memory::load(const std::string& filePath, uint16_t loadAddress) {
+bool readFile(const std::string& filePath, std::vector<uint8_t>& contents) {
     // Open the file for binary reading
     std::ifstream file(filePath, std::ios::binary);
 
@@ -16,27 +17,117 @@ bool Memory::load(const std::string& filePath, uint16_t loadAddress) {
     std::streampos fileSize = file.tellg();
     file.seekg(0, std::ios::beg);
 
-    // Check if there is enough memory to load the file
-    if (loadAddress + fileSize > 0xFFFF) {
-        std::cerr << "File size exceeds available memory space." << std::endl;
+    contents.resize(static_cast<size_t>(fileSize));
+    file.read(reinterpret_cast<char*>(contents.data()), fileSize);
+
+    if (!file) {
+        std::cerr << "Failed to read file: " << filePath << std::endl;
         return false;
     }
+    return true;
+}
 
-    // Read the file contents into memory starting from the specified loadAddress
-    file.read(reinterpret_cast<char*>(&memory[loadAddress]), fileSize);
+bool Memory::load(const std::string& filePath, uint16_t loadAddress) {
+    std::vector<uint8_t> contents;
+    return readFile(filePath, contents) && load(contents.data(), contents.size(), loadAddress);
+}
 
-    if (!file) {
-        std::cerr << "Failed to read file: " << filePath << std::endl;
+bool Memory::load(const uint8_t* image, size_t size, uint16_t loadAddress) {
+    // Check if there is enough memory to load the image
+    if (loadAddress + size > RAM_SIZE) {
+        std::cerr << "File size exceeds available memory space." << std::endl;
         return false;
     }
 
+    // Copy the image page by page into whatever storage each page maps to,
+    // read-only or not, and invalidate any code decoded from it
+    uint32_t addr = loadAddress, end = loadAddress + static_cast<uint32_t>(size);
+    while (addr < end) {
+        uint32_t page = addr / PAGE_SIZE;
+        uint32_t chunk = std::min(end, (page + 1) * PAGE_SIZE) - addr;
+        if (!readMap[page]) {
+            std::cerr << "Cannot load into unmapped or handler memory at " << addr << std::endl;
+            return false;
+        }
+        std::copy(image, image + chunk, readMap[page] + addr % PAGE_SIZE);
+        (*versionMap[page])++;
+        image += chunk;
+        addr += chunk;
+    }
     return true;
 }
 
-uint8_t Memory::read(uint16_t addr) {
-    return memory[addr];
+Memory::Memory() : memory() {
+    for (uint32_t page = 0; page < PAGES; page++) {
+        pageFlags[page] = READ_DIRECT | WRITE_DIRECT;
+        readMap[page] = writeMap[page] = &memory[page * PAGE_SIZE];
+        versionMap[page] = &pageVersions[page];
+        handlerMap[page] = -1;
+    }
+}
+
+void Memory::setPage(uint32_t page, uint8_t* read, uint8_t* write, uint32_t* version, int16_t handler) {
+    (*versionMap[page])++;          // Whatever was decoded through the old mapping is stale
+    bool identity = read == &memory[page * PAGE_SIZE];
+    pageFlags[page] = (identity ? READ_DIRECT : 0) | (identity && write ? WRITE_DIRECT : 0);
+    readMap[page] = read;
+    writeMap[page] = write;
+    versionMap[page] = version;
+    handlerMap[page] = handler;
+    (*versionMap[page])++;
 }
 
-void Memory::write(uint16_t addr, uint8_t data) {
-    memory[addr] = data;
-}
\ No newline at end of file
+void Memory::map(uint16_t start, uint16_t end, Access access, uint16_t backing) {
+    for (uint32_t page = start / PAGE_SIZE; page <= end / PAGE_SIZE; page++) {
+        uint32_t backingPage = (backing / PAGE_SIZE + page - start / PAGE_SIZE) % PAGES;
+        uint8_t* bytes = &memory[backingPage * PAGE_SIZE];
+        setPage(page, bytes, access == Access::ReadWrite ? bytes : nullptr, &pageVersions[backingPage], -1);
+    }
+}
+
+void Memory::map(uint16_t start, uint16_t end, Handler handler) {
+    handlers.push_back(std::move(handler));
+    for (uint32_t page = start / PAGE_SIZE; page <= end / PAGE_SIZE; page++)
+        setPage(page, nullptr, nullptr, &pageVersions[page], static_cast<int16_t>(handlers.size() - 1));
+}
+
+void Memory::unmap(uint16_t start, uint16_t end) {
+    for (uint32_t page = start / PAGE_SIZE; page <= end / PAGE_SIZE; page++)
+        setPage(page, nullptr, nullptr, &pageVersions[page], -1);
+}
+
+// Mirrors, handlers and unmapped pages
+[[gnu::noinline]] uint8_t Memory::readSlow(uint16_t addr) const {
+    if (const uint8_t* page = readMap[addr / PAGE_SIZE]) return page[addr % PAGE_SIZE];
+    int16_t handler = handlerMap[addr / PAGE_SIZE];
+    if (handler >= 0 && handlers[handler].read) return handlers[handler].read(addr);
+    return 0xFF;    // Nothing drives the data bus
+}
+
+[[gnu::noinline]] void Memory::writeSlow(uint16_t addr, uint8_t data) {
+    if (uint8_t* page = writeMap[addr / PAGE_SIZE]) {
+        page[addr % PAGE_SIZE] = data;
+        (*versionMap[addr / PAGE_SIZE])++;
+        return;
+    }
+    int16_t handler = handlerMap[addr / PAGE_SIZE];
+    if (handler >= 0 && handlers[handler].write) {
+        handlers[handler].write(addr, data);
+        (*versionMap[addr / PAGE_SIZE])++;
+    } else {
+        illegalWriteCounts[addr / PAGE_SIZE]++;     // ROM, or nothing there
+    }
+}
+
+bool Memory::hasReadHandlers() const {
+    for (uint32_t page = 0; page < PAGES; page++)
+        if (!readMap[page] && handlerMap[page] >= 0 && handlers[handlerMap[page]].read) return true;
+    return false;
+}
+
+uint64_t Memory::illegalWrites() const {
+    uint64_t total = 0;
+    for (uint32_t count : illegalWriteCounts)
+        total += count;
+    return total;
+}
@@ -1,17 +1,124 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <vector>
 
-constexpr uint32_t RAM_SIZE = 0x10000; // 64Kb
+constexpr uint32_t RAM_SIZE  = 0x10000; // 64Kb
+constexpr uint32_t PAGE_SIZE = 0x100;
+constexpr uint32_t PAGES     = RAM_SIZE / PAGE_SIZE;
 
+// The CPU's 64 KB address space, decoded through a table of 256-byte pages.
+//
+// A page either points straight at backing storage (a flat 64 KB array,
+// several pages may share the same bytes to mirror them) or hands accesses to
+// a Handler. Direct pages are read-write or read-only; writes to a read-only
+// page, to a handler page without a write function, or to an unmapped page
+// are dropped and counted in illegalWrites(). Unmapped pages read as 0xFF.
+//
+// The fast path covers pages mapped onto their own address in the backing
+// store, which is all of them in a flat RAM and all but the mirrors in a real
+// memory map: read() and write() test a per-page flag and access the array
+// directly, so the flag load runs alongside the data load rather than in
+// front of it. Everything else goes through the full page table. The fast
+// paths are defined below so that they inline into the CPU's handlers even
+// without link-time optimisation; read16() and write16() take a word that
+// does not cross a page boundary with a single flag test.
+//
+// A new Memory maps every page read-write onto the same address of the
+// backing store, i.e. a plain flat 64 KB RAM.
 class Memory {
 public:
+    enum class Access : uint8_t { ReadWrite, ReadOnly };
+
+    struct Handler {
+        std::function<uint8_t(uint16_t addr)>             read;     // Unset: reads 0xFF
+        std::function<void(uint16_t addr, uint8_t data)>  write;    // Unset: writes are illegal
+    };
+
+    Memory();
+    Memory(const Memory&) = delete;                                 // Pages point into the object itself
+    Memory& operator=(const Memory&) = delete;
+
+    // Page-aligned ranges, `end` inclusive (e.g. 0x2000, 0x3FFF). Remapping
+    // bumps the page versions, so code decoded from the old mapping is dropped.
+    void     map(uint16_t start, uint16_t end, Access access, uint16_t backing);   // Direct, onto storage at `backing`
+    void     map(uint16_t start, uint16_t end, Handler handler);
+    void     unmap(uint16_t start, uint16_t end);
+
     bool     load(const std::string& filePath, uint16_t loadAddress);
-    uint8_t  read(uint16_t addr);
+    bool     load(const uint8_t* image, size_t size, uint16_t loadAddress);   // Through the map, ignoring protection
+    uint8_t  read(uint16_t addr) const;
     void     write(uint16_t addr, uint8_t data);
+    uint16_t read16(uint16_t addr) const;                           // Little-endian word at addr, addr + 1
+    void     write16(uint16_t addr, uint16_t data);
+    const uint8_t* data() const { return memory; }                  // Raw view of the backing storage
+    uint32_t pageVersion(uint8_t page) const { return *versionMap[page]; }
+    const uint32_t* pageVersionAddress(uint8_t page) const { return versionMap[page]; }
+
+    bool     hasReadHandlers() const;                               // Some page is read through a Handler::read
+    uint64_t illegalWrites() const;                                 // Dropped writes so far, all pages
+    uint32_t illegalWrites(uint8_t page) const { return illegalWriteCounts[page]; }
 
 private:
     uint8_t memory[RAM_SIZE];
-};
\ No newline at end of file
+
+    // Fast path flags: the page is direct and mapped onto its own address
+    enum PageFlags : uint8_t { READ_DIRECT = 1, WRITE_DIRECT = 2 };
+    std::array<uint8_t, PAGES>   pageFlags;
+
+    // The page table: a direct page has its backing bytes in readMap (and in
+    // writeMap if writable); null entries go to the page's handler, if any
+    std::array<uint8_t*, PAGES>  readMap;
+    std::array<uint8_t*, PAGES>  writeMap;
+    std::array<uint32_t*, PAGES> versionMap;    // Write counter of each page's backing page, shared by mirrors
+    std::array<int16_t, PAGES>   handlerMap;    // Index into `handlers`, -1 if none
+    std::vector<Handler>         handlers;
+
+    // Write counter for each 256-byte page. Decoded code (see BlockCache)
+    // remembers the counters of the pages it came from to detect stale bytes,
+    // and Display compares them frame to frame to find changed VRAM strips.
+    // Counters belong to backing pages; handler and unmapped pages use the
+    // counter of their own address.
+    std::array<uint32_t, PAGES> pageVersions{};
+    std::array<uint32_t, PAGES> illegalWriteCounts{};
+
+    uint8_t  readSlow(uint16_t addr) const;
+    void     writeSlow(uint16_t addr, uint8_t data);
+    void     setPage(uint32_t page, uint8_t* read, uint8_t* write, uint32_t* version, int16_t handler);
+};
+
+inline uint8_t Memory::read(uint16_t addr) const {
+    if (!(pageFlags[addr / PAGE_SIZE] & READ_DIRECT)) [[unlikely]] return readSlow(addr);
+    return memory[addr];
+}
+
+inline void Memory::write(uint16_t addr, uint8_t data) {
+    if (!(pageFlags[addr / PAGE_SIZE] & WRITE_DIRECT)) [[unlikely]] return writeSlow(addr, data);
+    memory[addr] = data;
+    pageVersions[addr / PAGE_SIZE]++;
+}
+
+inline uint16_t Memory::read16(uint16_t addr) const {
+    if (addr % PAGE_SIZE == PAGE_SIZE - 1 || !(pageFlags[addr / PAGE_SIZE] & READ_DIRECT)) [[unlikely]]
+        return read(addr) | read(addr + 1) << 8;
+    return memory[addr] | memory[addr + 1] << 8;
+}
+
+inline void Memory::write16(uint16_t addr, uint16_t data) {
+    if (addr % PAGE_SIZE == PAGE_SIZE - 1 || !(pageFlags[addr / PAGE_SIZE] & WRITE_DIRECT)) [[unlikely]] {
+        write(addr, data & 0xFF);
+        write(addr + 1, data >> 8);
+        return;
+    }
+    memory[addr] = data & 0xFF;
+    memory[addr + 1] = data >> 8;
+    pageVersions[addr / PAGE_SIZE]++;
+}
+
+// Reads a whole file into `contents`
+bool readFile(const std::string& filePath, std::vector<uint8_t>& contents);
@@ -0,0 +1,109 @@
+#include "movie.hpp"
+#include "io.hpp"
+#include "memory.hpp"
+#include "serialize.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+void Movie::start(uint64_t romHash) {
+    rom = romHash;
+    changes.clear();
+    hashes.clear();
+}
+
+void Movie::record(uint8_t frameInputs, uint64_t ramHash) {
+    if (changes.empty() || changes.back().inputs != frameInputs)
+        changes.push_back({hashes.size(), frameInputs});
+    hashes.push_back(ramHash);
+}
+
+void Movie::truncate(uint64_t frames) {
+    if (frames >= hashes.size()) return;
+    hashes.resize(frames);
+    while (!changes.empty() && changes.back().frame >= frames)
+        changes.pop_back();
+}
+
+uint8_t Movie::inputs(uint64_t frame) const {
+    // The last change at or before `frame`
+    auto next = std::upper_bound(changes.begin(), changes.end(), frame,
+                                 [](uint64_t f, const InputChange& change) { return f < change.frame; });
+    return next == changes.begin() ? IOPorts::IN_PORT1_IDLE : std::prev(next)->inputs;
+}
+
+// Movie files are little-endian:
+//   "I8080MOV", u32 version, u64 ROM hash, u64 frame count, u64 input change count,
+//   per change: u32 frames since the previous change, u8 port 1 value,
+//   per frame:  u64 RAM hash
+constexpr char MOVIE_MAGIC[8] = {'I', '8', '0', '8', '0', 'M', 'O', 'V'};
+
+bool Movie::save(const std::string& filePath) const {
+    std::vector<uint8_t> out(MOVIE_MAGIC, MOVIE_MAGIC + sizeof(MOVIE_MAGIC));
+    putLE(out, VERSION);
+    putLE(out, rom);
+    putLE(out, static_cast<uint64_t>(hashes.size()));
+    putLE(out, static_cast<uint64_t>(changes.size()));
+    uint64_t previous = 0;
+    for (const InputChange& change : changes) {
+        putLE(out, static_cast<uint32_t>(change.frame - previous));
+        putLE(out, change.inputs);
+        previous = change.frame;
+    }
+    for (uint64_t hash : hashes)
+        putLE(out, hash);
+
+    std::ofstream file(filePath, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+    if (!file) {
+        std::cerr << "Failed to write movie: " << filePath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Movie::load(const std::string& filePath) {
+    std::vector<uint8_t> in;
+    if (!readFile(filePath, in)) return false;
+
+    if (in.size() < sizeof(MOVIE_MAGIC) || !std::equal(MOVIE_MAGIC, MOVIE_MAGIC + sizeof(MOVIE_MAGIC), in.begin())) {
+        std::cerr << "Not a movie file: " << filePath << std::endl;
+        return false;
+    }
+
+    size_t at = sizeof(MOVIE_MAGIC);
+    uint32_t version = 0;
+    if (!getLE(in, at, version) || version != VERSION) {
+        std::cerr << "Unsupported movie version " << version << ": " << filePath << std::endl;
+        return false;
+    }
+
+    uint64_t frameCount = 0, changeCount = 0;
+    bool ok = getLE(in, at, rom) && getLE(in, at, frameCount) && getLE(in, at, changeCount) &&
+              in.size() - at == changeCount * 5 + frameCount * 8;
+    changes.clear();
+    hashes.clear();
+    uint64_t frame = 0;
+    for (uint64_t i = 0; ok && i < changeCount; i++) {
+        uint32_t delta = 0;
+        InputChange change{};
+        ok = getLE(in, at, delta) && getLE(in, at, change.inputs);
+        if (!ok) break;
+        change.frame = frame += delta;
+        changes.push_back(change);
+    }
+    for (uint64_t i = 0; ok && i < frameCount; i++) {
+        uint64_t hash = 0;
+        ok = getLE(in, at, hash);
+        if (!ok) break;
+        hashes.push_back(hash);
+    }
+    if (!ok) {
+        std::cerr << "Corrupt movie file: " << filePath << std::endl;
+        changes.clear();
+        hashes.clear();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A recorded run of the machine from power-on: the player inputs, and the
+// RAM hash after every frame to check a replay against.
+//
+// Inputs are latched once per frame, before it runs (Machine::setInputs), so
+// a run is a pure function of the ROM and the port 1 value of each frame,
+// and only the frames where it changes are stored. Replaying the inputs on
+// any engine must then reproduce every recorded hash; the first frame that
+// does not is where emulation diverged.
+//
+// Frames are numbered by Machine::frameCount() at the start of the frame,
+// so after rewinding, truncate() to the restored frame count and carry on.
+class Movie {
+public:
+    static constexpr uint32_t VERSION = 1;
+
+    void     start(uint64_t romHash);                       // Begin a new recording of the given ROM
+    void     record(uint8_t inputs, uint64_t ramHash);      // Append the next frame
+    void     truncate(uint64_t frames);                     // Forget every frame from `frames` on
+
+    uint8_t  inputs(uint64_t frame) const;                  // Port 1 value latched for `frame`
+    uint64_t ramHash(uint64_t frame) const                  { return hashes[frame]; }
+    uint64_t frames() const                                 { return hashes.size(); }
+    uint64_t romHash() const                                { return rom; }
+
+    bool     save(const std::string& filePath) const;
+    bool     load(const std::string& filePath);
+
+private:
+    struct InputChange {
+        uint64_t frame;
+        uint8_t  inputs;
+    };
+
+    uint64_t                 rom = 0;
+    std::vector<InputChange> changes;       // In frame order
+    std::vector<uint64_t>    hashes;        // Machine::ramHash() after each frame
+};
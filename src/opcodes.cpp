@@ -1,136 +1,78 @@
 #include "cpu.hpp"
+#include "aot.hpp"
+#include "blockcache.hpp"
+#include "jit.hpp"
+#include "opinline.hpp"
+
+#include <utility>
 
 // Add immediate to accumulator with carry
 void Intel8080::ACI() {
-    temp8 = read(pc++);
-    temp16 = (uint16_t) reg8[A] + (uint16_t) temp8 + (uint16_t) GetFlag(CY);
-    SetFlag(AC, carry(reg8[A], temp8 + GetFlag(CY), temp16, 0x08));
-    SetFlag(CY, temp16 & 0xFF00);
-    SetZSP(static_cast<uint8_t>(temp16));
-    reg8[A] = temp16 & 0xFF;
-    cycles -= 7;
+    aluAdd(read(pc++), GetFlag(CY));
 }
 
 // Add register to accumulator with carry
 void Intel8080::ADC() {
-    reg = opcode & 7;
-    temp8 = readReg8(reg);
-    temp16 = (uint16_t) reg8[A] + (uint16_t) temp8 + (uint16_t) GetFlag(CY);
-    SetFlag(AC, carry(reg8[A], temp8 + GetFlag(CY), temp16, 0x08));
-    SetFlag(CY, temp16 & 0xFF00);
-    SetZSP(static_cast<uint8_t>(temp16));
-    reg8[A] = temp16 & 0xFF;
-    if (reg == M)
-        cycles -= 7;
-    else
-        cycles -= 4;
+    aluAdd(readReg8(opcode & 7), GetFlag(CY));
 }
 
 // Add register/memory to accumulator
 void Intel8080::ADD() {
-    reg = opcode & 7;
-    temp8 = readReg8(reg);
-    temp16 = (uint16_t) reg8[A] + (uint16_t) temp8;
-    SetFlag(CY, temp16 & 0xFF00);
-    SetFlag(AC, carry(reg8[A], temp8, temp16, 0x08));
-    SetZSP(static_cast<uint16_t>(temp16));
-    reg8[A] = temp16 & 0xFF;
-    if (reg == M)
-        cycles -= 7;
-    else
-        cycles -= 4;
+    aluAdd(readReg8(opcode & 7), 0);
 }
 
 // Add immediate to accumulator
 void Intel8080::ADI() {
-    temp8 = read(pc++);
-    temp16 = (uint16_t) reg8[A] + (uint16_t) temp8;
-    SetFlag(CY, temp16 & 0xFF00);
-    SetFlag(AC, carry(reg8[A], temp8, temp16, 0x08));
-    SetZSP(static_cast<uint16_t>(temp16));
-    reg8[A] = temp16 & 0xFF;
-    cycles -= 7;
+    aluAdd(read(pc++), 0);
 }
 
 // Logical AND with accumulator
 void Intel8080::ANA() {
-    reg = opcode & 7;
-    temp8 = readReg8(reg);
-    SetFlag(AC, (reg8[A] | temp8) & 0x80);
-    SetFlag(CY, false);
-    reg8[A] &= temp8;
-    SetZSP(reg8[A]);
-    if (reg == M)
-        cycles -= 7;
-    else
-        cycles -= 4;
+    aluAnd(readReg8(opcode & 7));
 }
 
 // Logical AND immediate with accumulator
 void Intel8080::ANI() {
-    temp8 = read(pc++);
-    SetFlag(AC, (reg8[A] | temp8) & 0x80);
-    SetFlag(CY, false);
-    reg8[A] &= temp8;
-    SetZSP(reg8[A]);
-    cycles -= 4;
+    aluAnd(read(pc++));
 }
 
 // Call
 void Intel8080::CALL() {
-    temp16 = (uint16_t) read(pc) | (((uint16_t) read(pc + 1)) << 8);
+    temp16 = fetch16();
     push(pc + 2);
     pc = temp16;
-    cycles -= 17;
 }
 
 // Conditional call
 void Intel8080::Cccc() {
-    temp16 = (uint16_t) read(pc) | (((uint16_t) read(pc + 1)) << 8);
+    temp16 = fetch16();
     if (TestCond((opcode >> 3) & 7)) {
         push(pc + 2);
         pc = temp16;
-        cycles -= 17;
+        chargeTaken();
     } else {
         pc += 2;
-        cycles -= 11;
     }
 }
 
 // Complement accumulator
 void Intel8080::CMA() {
     reg8[A] = ~reg8[A];
-    cycles -= 4;
 }
 
 // Complement carry
 void Intel8080::CMC() {
     reg8[FLAGS] ^= 1;
-    cycles -= 4;
 }
 
 // Compare register/memory with accumulator
 void Intel8080::CMP() {
-    reg = opcode & 7;
-    temp8 = readReg8(reg);
-    temp16 = (uint16_t) reg8[A] - (uint16_t) temp8;
-    SetFlag(CY, reg8[A] < temp8);
-    SetFlag(AC, (reg8[A] & 0x0F) < (temp8 & 0x0F));
-    SetZSP(static_cast<uint8_t>(temp16));
-    if (reg == M)
-        cycles -= 7;
-    else
-        cycles -= 4;
+    aluCmp(readReg8(opcode & 7));
 }
 
 // Compare immediate with accumulator
 void Intel8080::CPI() {
-    temp8 = read(pc++);
-    temp16 = (uint16_t) reg8[A] - (uint16_t) temp8;
-    SetFlag(CY, borrow(reg8[A], temp8, temp16, 0x80));
-    SetFlag(AC, borrow(reg8[A], temp8, temp16, 0x08));
-    SetZSP(static_cast<uint8_t>(temp16));
-    cycles -= 4;
+    aluCmp(read(pc++));
 }
 
 // Decimal adjust accumulator
@@ -147,7 +89,6 @@ void Intel8080::DAA() {
     }
     SetZSP(static_cast<uint8_t>(temp16));
     reg8[A] = temp16 & 0xFF;
-    cycles -= 4;
 }
 
 // Double register add
@@ -156,118 +97,103 @@ void Intel8080::DAD() {
     temp32 = (uint32_t) reg16_HL() + (uint32_t) readRP(reg);
     write16RP(2, static_cast<uint16_t>(temp32));
     SetFlag(CY, temp32 & 0xFFFF0000);
-    cycles -= 10;
 }
 
 // Decrement register/memory
 void Intel8080::DCR() {
     reg = (opcode >> 3) & 7;
-    temp8 = readReg8(reg);
-    SetFlag(AC, (temp8 & 0x0F) == 0);
-    SetZSP(temp8 - 1);
-    writeReg8(reg, temp8 - 1);
-    if (reg == M)
-        cycles -= 10;
-    else
-        cycles -= 5;
+    writeReg8(reg, aluDcr(readReg8(reg)));
 }
 
 // Decrement register pair
 void Intel8080::DCX() {
     reg = (opcode >> 4) & 3;
     write16RP(reg, readRP(reg) - 1);
-    cycles -= 5;
 }
 
 // Disable interrupts
 void Intel8080::DI() {
     intEnable = 0;
-    cycles -= 4;
 }
 
 // Enable interrupts
 void Intel8080::EI() {
     intEnable = 1;
-    cycles -= 4;
 }
 
 // Halt
 void Intel8080::HLT() {
     pc--;
-    cycles -= 7;
+    // Repeating HLT until the budget runs out ends on the same cycle count
+    if (skipping && cycles > 0) {
+        constexpr int cost = OPCODES[0x76].cycles;
+        int repeats = (cycles + cost - 1) / cost;
+        cycles -= cost * repeats;
+        idleSkipped += cost * repeats;
+    }
 }
 
 // Input fom port
 void Intel8080::IN() {
     reg8[A] = inport(read(pc++));
-    cycles -= 10;
 }
 
 // Increment register/memory
 void Intel8080::INR() {
     reg = (opcode >> 3) & 7;
-    temp8 = readReg8(reg);
-    SetFlag(AC, carry(temp8, 1, temp8 + 1, 0x08));
-    SetZSP(temp8 + 1);
-    writeReg8(reg, temp8 + 1);
-    if (reg == M)
-        cycles -= 10;
-    else
-        cycles -= 5;
+    writeReg8(reg, aluInr(readReg8(reg)));
 }
 
 // Increment register pair
 void Intel8080::INX() {
     reg = (opcode >> 4) & 3;
     write16RP(reg, readRP(reg) + 1);
-    cycles -= 5;
 }
 
 // Jump
 void Intel8080::JMP() {
-    temp16 = (uint16_t) read(pc) | (((uint16_t) read(pc + 1)) << 8);
+    temp16 = fetch16();
+    if (skipping && temp16 < pc && pc - temp16 <= IDLE_LOOP_BYTES) idleLoop(temp16, pc - 1);
     pc = temp16;
-    cycles -= 10;
 }
 
 // Conditional jump
 void Intel8080::Jccc() {
-    temp16 = (uint16_t) read(pc) | (((uint16_t) read(pc + 1)) << 8);
-    if (TestCond((opcode >> 3) & 7))    pc = temp16;
-    else                                pc += 2;
-    cycles -= 10;
+    temp16 = fetch16();
+    if (TestCond((opcode >> 3) & 7)) {
+        if (skipping && temp16 < pc && pc - temp16 <= IDLE_LOOP_BYTES) idleLoop(temp16, pc - 1);
+        pc = temp16;
+    } else {
+        if (skipping) idleExit(pc - 1);
+        pc += 2;
+    }
 }
 
 // Load accumulator direct
 void Intel8080::LDA() {
-    temp16 = (uint16_t) read(pc) | ((uint16_t) read(pc + 1) << 8);
+    temp16 = fetch16();
     reg8[A] = read(temp16);
     pc += 2;
-    cycles -= 13;
 }
 
 // Load accumulator indirect
 void Intel8080::LDAX() {
     reg = (opcode >> 4) & 3;
     reg8[A] = read(readRP(reg));
-    cycles -= 7;
 }
 
 // Load H and L direct
 void Intel8080::LHLD() {
-    temp16 = (uint16_t) read(pc) | ((uint16_t) read(pc + 1) << 8);
-    reg8[L] = read(temp16 + 0);
-    reg8[H] = read(temp16 + 1);
+    temp16 = fetch16();
+    write16RP(2, read16(temp16));
     pc += 2;
-    cycles -= 16;
 }
 
 // Load register pair immediate
 void Intel8080::LXI() {
     reg = (opcode >> 4) & 3;
-    writeRP(reg, read(pc), read(pc + 1));
+    write16RP(reg, fetch16());
     pc += 2;
-    cycles -= 10;
 }
 
 // Move data between register/memory
@@ -275,66 +201,42 @@ void Intel8080::MOV() {
     reg  = (opcode >> 3) & 7;
     reg2 = opcode & 7;
     writeReg8(reg, readReg8(reg2));
-    if (reg == M || reg2 == M)
-        cycles -= 7;
-    else
-        cycles -= 5;
 }
 
 // Move immediate to register/memory
 void Intel8080::MVI() {
     reg = (opcode >> 3) & 7;
     writeReg8(reg, read(pc++));
-    if (reg == M)
-        cycles -= 10;
-    else
-        cycles -= 7;
 }
 
 // No operation
 void Intel8080::NOP() {
-    cycles -= 4;
 }
 
 // Inclusive OR with accumulator
 void Intel8080::ORA() {
-    reg = opcode & 7;
-    reg8[A] |= readReg8(reg);
-    SetFlag(AC, false);
-    SetFlag(CY, false);
-    SetZSP(reg8[A]);
-    if (reg == M)
-        cycles -= 7;
-    else
-        cycles -= 4;
+    aluOr(readReg8(opcode & 7));
 }
 
 // Inclusive OR immediate
 void Intel8080::ORI() {
-    reg8[A] |= read(pc++);
-    SetFlag(AC, false);
-    SetFlag(CY, false);
-    SetZSP(reg8[A]);
-    cycles -= 7;
+    aluOr(read(pc++));
 }
 
 // Output to port
 void Intel8080::OUT() {
     outport(read(pc++), reg8[A]);
-    cycles -= 10;
 }
 
 // Move H&L to program counter
 void Intel8080::PCHL() {
     pc = reg16_HL();
-    cycles -= 5;
 }
 
 // Pop
 void Intel8080::POP() {
     reg = (opcode >> 4) & 3;
     write16RP_PUSHPOP(reg, pop());
-    cycles -= 10;
 }
 
 
@@ -342,7 +244,6 @@ void Intel8080::POP() {
 void Intel8080::PUSH() {
     reg = (opcode >> 4) & 3;
     push(readRP_PUSHPOP(reg));
-    cycles -= 11;
 }
 
 // Rotate left through carry
@@ -350,7 +251,6 @@ void Intel8080::RAL() {
     temp8 = GetFlag(CY);
     SetFlag(CY, reg8[A] & 0x80);
     reg8[A] = (reg8[A] << 1) | temp8;
-    cycles -= 4;
 }
 
 // Rotate right through carry
@@ -358,22 +258,18 @@ void Intel8080::RAR() {
     temp8 = GetFlag(CY);
     SetFlag(CY, reg8[A] & 1);
     reg8[A] = (temp8 << 7) | (reg8[A] >> 1);
-    cycles -= 4;
 }
 
 // Return
 void Intel8080::RET() {
     pc = pop();
-    cycles -= 10;
 }
 
 // Conditional return
 void Intel8080::Rccc() {
     if (TestCond((opcode >> 3) & 7)) {
         pc = pop();
-        cycles -= 11;
-    } else {
-        cycles -= 5;
+        chargeTaken();
     }
 }
 
@@ -381,70 +277,47 @@ void Intel8080::Rccc() {
 void Intel8080::RLC() {
     SetFlag(CY, reg8[A] & 0x80);
     reg8[A] = (reg8[A] << 1) | (reg8[A] >> 7);
-    cycles -= 4;
 }
 
 // Rotate accumulator right
 void Intel8080::RRC() {
     SetFlag(CY, reg8[A] & 1);
     reg8[A] = (reg8[A] << 7) | (reg8[A] >> 1);
-    cycles -= 4;
 }
 
 // Restart
 void Intel8080::RST() {
     push(pc);
     pc = (uint16_t) ((opcode >> 3) & 7) << 3; // Call n * 8
-    cycles -= 11;
 }
 
 // Subtract register/memory with borrow
 void Intel8080::SBB() {
-    reg = opcode & 7;
-    temp8 = readReg8(reg);
-    temp16 = (uint16_t) reg8[A] - (uint16_t) temp8 - (uint16_t) GetFlag(CY);
-    SetFlag(AC, borrow(reg8[A], temp8 + GetFlag(CY), temp16, 0x08));
-    SetFlag(CY, borrow(reg8[A], temp8 + GetFlag(CY), temp16, 0x80));
-    SetZSP(static_cast<uint8_t>(temp16));
-    reg8[A] = temp16 & 0xFF;
-    if (reg == M)
-        cycles -= 7;
-    else
-        cycles -= 4;
+    aluSub(readReg8(opcode & 7), GetFlag(CY));
 }
 
 // Subtract immediate with borrow
 void Intel8080::SBI() {
-    temp8 = read(pc++);
-    temp16 = (uint16_t) reg8[A] - (uint16_t) temp8 - GetFlag(CY);
-    SetFlag(AC, borrow(reg8[A], temp8 + GetFlag(CY), temp16, 0x08));
-    SetFlag(CY, borrow(reg8[A], temp8 + GetFlag(CY), temp16, 0x80));
-    SetZSP(static_cast<uint8_t>(temp16));
-    reg8[A] = temp16 & 0xFF;
-    cycles -= 7;
+    aluSub(read(pc++), GetFlag(CY));
 }
 
 // Store H and L direct
 void Intel8080::SHLD() {
-    temp16 = (uint16_t) read(pc) | ((uint16_t) read(pc + 1) << 8);
-    write(temp16 + 0, reg8[L]);
-    write(temp16 + 1, reg8[H]);
+    temp16 = fetch16();
+    write16(temp16, reg16_HL());
     pc += 2;
-    cycles -= 16;
 }
 
 // Move H&L to SP
 void Intel8080::SPHL() {
     sp = reg16_HL();
-    cycles -= 5;
 }
 
 // Store accumulator direct
 void Intel8080::STA() {
-    temp16 = (uint16_t) read(pc) | ((uint16_t) read(pc + 1) << 8);
+    temp16 = fetch16();
     write(temp16, reg8[A]);
     pc += 2;
-    cycles -= 13;
 }
 
 // Store accumulator indirect
@@ -456,33 +329,16 @@ void Intel8080::STAX() {
 // Set carry
 void Intel8080::STC() {
     SetFlag(CY, true);
-    cycles -= 4;
 }
 
 // Subtract register/memory from accumulator
 void Intel8080::SUB() {
-    reg = opcode & 7;
-    temp8 = readReg8(reg);
-    temp16 = (uint16_t) reg8[A] - (uint16_t) temp8;
-    SetFlag(AC, borrow(reg8[A], temp8, temp16, 0x08));
-    SetFlag(CY, borrow(reg8[A], temp8, temp16, 0x80));
-    SetZSP(static_cast<uint8_t>(temp16));
-    reg8[A] = temp16 & 0xFF;
-    if (reg == M)
-        cycles -= 7;
-    else
-        cycles -= 4;
+    aluSub(readReg8(opcode & 7), 0);
 }
 
 // Subtract immediate from accumulator
 void Intel8080::SUI() {
-    temp8 = read(pc++);
-    temp16 = (uint16_t) reg8[A] - (uint16_t) temp8;
-    SetFlag(AC, borrow(reg8[A], temp8, temp16, 0x08));
-    SetFlag(CY, borrow(reg8[A], temp8, temp16, 0x80));
-    SetZSP(static_cast<uint8_t>(temp16));
-    reg8[A] = temp16 & 0xFF;
-    cycles -= 7;
+    aluSub(read(pc++), 0);
 }
 
 // Exhange H and L with D and E
@@ -493,42 +349,632 @@ void Intel8080::XCHG() {
     temp8 = reg8[L];
     reg8[L] = reg8[E];
     reg8[E] = temp8;
-    cycles -= 5;
 }
 
 // Exclusive OR with accumulator
 void Intel8080::XRA() {
-    reg = opcode & 7;
-    reg8[A] ^= readReg8(reg);
-    SetFlag(AC, false);
-    SetFlag(CY, false);
-    SetZSP(reg8[A]);
-    if (reg == M)
-        cycles -= 7;
-    else
-        cycles -= 4;
+    aluXor(readReg8(opcode & 7));
 }
 
 // Exclusive OR immediate with accumulator
 void Intel8080::XRI() {
-    temp8 = read(pc++);
-    reg8[A] ^= temp8;
-    SetFlag(AC, false);
-    SetFlag(CY, false);
-    SetZSP(reg8[A]);
-    cycles -= 7;
+    aluXor(read(pc++));
 }
 
 // Exchange H&L with top of stack
 void Intel8080::XTHL() {
-    temp16 = pop();
-    push(reg16_HL());
+    temp16 = read16(sp);
+    write16(sp, reg16_HL());
     write16RP(2, temp16);
-    cycles -= 18;
 }
 
 // Unimplemented instruction
 void Intel8080::XXX() {
     printf("UNRECOGNIZED INSTRUCTION @ %04Xh: %02X\n", pc - 1, opcode);
     exit(0);
-}
\ No newline at end of file
+}
+
+/* Switch and block dispatch engines */
+
+// Charges the current opcode's cycles and runs its handler through a switch.
+// Living in this translation unit lets the compiler inline the handlers into
+// the jump table targets, which removes the member-function-pointer call and
+// gives each opcode its own indirect branch site.
+inline void Intel8080::step() {
+    charge();
+    switch (opcode) {
+        // 0x00 - 0x0f
+        case 0x00: NOP();       break; // NOP
+        case 0x01: LXI();       break; // LXI B,d16
+        case 0x02: STAX();      break; // STAX B
+        case 0x03: INX();       break; // INX B
+        case 0x04: INR();       break; // INR B
+        case 0x05: DCR();       break; // DCR B
+        case 0x06: MVI();       break; // MVI B,d8
+        case 0x07: RLC();       break; // RLC
+        case 0x08: XXX();       break; // *NOP (unimplemented)
+        case 0x09: DAD();       break; // DAD B
+        case 0x0a: LDAX();      break; // LDAX B
+        case 0x0b: DCX();       break; // DXC B
+        case 0x0c: INR();       break; // INR C
+        case 0x0d: DCR();       break; // DCR C
+        case 0x0e: MVI();       break; // MVI C,d8
+        case 0x0f: RRC();       break; // RRC
+
+        // 0x10 - 0x1f
+        case 0x10: XXX();       break; // *NOP (unimplemented)
+        case 0x11: LXI();       break; // LXI D,d16
+        case 0x12: STAX();      break; // STAX D
+        case 0x13: INX();       break; // INX D
+        case 0x14: INR();       break; // INR D
+        case 0x15: DCR();       break; // DCR D
+        case 0x16: MVI();       break; // MVI D,d8
+        case 0x17: RAL();       break; // RAL
+        case 0x18: XXX();       break; // *NOP (unimplemented)
+        case 0x19: DAD();       break; // DAD D
+        case 0x1a: LDAX();      break; // LDAX D
+        case 0x1b: DCX();       break; // DCX D
+        case 0x1c: INR();       break; // INR E
+        case 0x1d: DCR();       break; // DCR E
+        case 0x1e: MVI();       break; // MVI E,d8
+        case 0x1f: RAR();       break; // RAR
+
+        // 0x20 - 0x2f
+        case 0x20: XXX();       break; // *NOP (unimplemented)
+        case 0x21: LXI();       break; // LXI H,d16
+        case 0x22: SHLD();      break; // SHLD
+        case 0x23: INX();       break; // INX H
+        case 0x24: INR();       break; // INR H
+        case 0x25: DCR();       break; // DCR H
+        case 0x26: MVI();       break; // MVI H,d8
+        case 0x27: DAA();       break; // DAA
+        case 0x28: XXX();       break; // *NOP (unimplemented)
+        case 0x29: DAD();       break; // DAD H
+        case 0x2a: LHLD();      break; // LHLD
+        case 0x2b: DCX();       break; // DCX H
+        case 0x2c: INR();       break; // INR L
+        case 0x2d: DCR();       break; // DCR L
+        case 0x2e: MVI();       break; // MVI L,d8
+        case 0x2f: CMA();       break; // CMA
+
+        // 0x30 - 0x3f
+        case 0x30: XXX();       break; // *NOP (unimplemented)
+        case 0x31: LXI();       break; // LXI SP,d16
+        case 0x32: STA();       break; // STA a16
+        case 0x33: INX();       break; // INX SP
+        case 0x34: INR();       break; // INR M
+        case 0x35: DCR();       break; // DCR M
+        case 0x36: MVI();       break; // MVI M,d8
+        case 0x37: STC();       break; // STC
+        case 0x38: XXX();       break; // *NOP (unimplemented)
+        case 0x39: DAD();       break; // DAD SP
+        case 0x3a: LDA();       break; // LDA a16
+        case 0x3b: DCX();       break; // DCX SP
+        case 0x3c: INR();       break; // INR A
+        case 0x3d: DCR();       break; // DCR A
+        case 0x3e: MVI();       break; // MVI A,d8
+        case 0x3f: CMC();       break; // CMC
+
+        // 0x40 - 0x4f (All MOV)
+        case 0x40:
+        case 0x41:
+        case 0x42:
+        case 0x43:
+        case 0x44:
+        case 0x45:
+        case 0x46:
+        case 0x47:
+        case 0x48:
+        case 0x49:
+        case 0x4a:
+        case 0x4b:
+        case 0x4c:
+        case 0x4d:
+        case 0x4e:
+        case 0x4f:
+
+        // 0x50 - 0x5f (All MOV)
+        case 0x50:
+        case 0x51:
+        case 0x52:
+        case 0x53:
+        case 0x54:
+        case 0x55:
+        case 0x56:
+        case 0x57:
+        case 0x58:
+        case 0x59:
+        case 0x5a:
+        case 0x5b:
+        case 0x5c:
+        case 0x5d:
+        case 0x5e:
+        case 0x5f:
+
+        // 0x60 - 0x6f (All MOV)
+        case 0x60:
+        case 0x61:
+        case 0x62:
+        case 0x63:
+        case 0x64:
+        case 0x65:
+        case 0x66:
+        case 0x67:
+        case 0x68:
+        case 0x69:
+        case 0x6a:
+        case 0x6b:
+        case 0x6c:
+        case 0x6d:
+        case 0x6e:
+        case 0x6f:
+
+        // 0x70 - 0x7f
+        case 0x70:
+        case 0x71:
+        case 0x72:
+        case 0x73:
+        case 0x74:
+        case 0x75: MOV();       break;
+        case 0x76: HLT();       break; // HLT
+        case 0x77:
+        case 0x78:
+        case 0x79:
+        case 0x7a:
+        case 0x7b:
+        case 0x7c:
+        case 0x7d:
+        case 0x7e:
+        case 0x7f: MOV();       break; // MOV
+
+        // 0x80 - 0x8f
+        case 0x80:
+        case 0x81:
+        case 0x82:
+        case 0x83:
+        case 0x84:
+        case 0x85:
+        case 0x86:
+        case 0x87: ADD();       break; // ADD B, C, D, E, H, L, M, A
+        case 0x88:
+        case 0x89:
+        case 0x8a:
+        case 0x8b:
+        case 0x8c:
+        case 0x8d:
+        case 0x8e:
+        case 0x8f: ADC();       break; // ADC B, C, D, E, H, L, M, A
+
+        // 0x90 - 0x9f
+        case 0x90:
+        case 0x91:
+        case 0x92:
+        case 0x93:
+        case 0x94:
+        case 0x95:
+        case 0x96:
+        case 0x97: SUB();       break; // SUB B, C, D, E, H, L, M, A
+        case 0x98:
+        case 0x99:
+        case 0x9a:
+        case 0x9b:
+        case 0x9c:
+        case 0x9d:
+        case 0x9e:
+        case 0x9f: SBB();       break; // SBB B, C, D, E, H, L, M, A
+
+
+        // 0Xa0 - 0xaf
+        case 0xa0:
+        case 0xa1:
+        case 0xa2:
+        case 0xa3:
+        case 0xa4:
+        case 0xa5:
+        case 0xa6:
+        case 0xa7: ANA();       break; // ANA B, C, D, E, H, L, M, A
+        case 0xa8:
+        case 0xa9:
+        case 0xaa:
+        case 0xab:
+        case 0xac:
+        case 0xad:
+        case 0xae:
+        case 0xaf: XRA();       break; // XRA B, C, D, E, H, L, M, A
+
+        // 0xb0 - 0xbf
+        case 0xb0:
+        case 0xb1:
+        case 0xb2:
+        case 0xb3:
+        case 0xb4:
+        case 0xb5:
+        case 0xb6:
+        case 0xb7: ORA();       break; // ORA B, C, D, E, H, L, M, A
+        case 0xb8:
+        case 0xb9:
+        case 0xba:
+        case 0xbb:
+        case 0xbc:
+        case 0xbd:
+        case 0xbe:
+        case 0xbf: CMP();       break; // CMP B, C, D, E, H, L, M, A
+
+        // 0xc0 - 0xcf
+        case 0xc0: Rccc();      break; // RNZ = RET if not zero (Z = 0)
+        case 0xc1: POP();       break; // POP B
+        case 0xc2: Jccc();      break; // JNZ a16 = JMP a16 if not zero (Z = 0)
+        case 0xc3: JMP();       break; // JMP a16
+        case 0xc4: Cccc();      break; // CNZ a16 = CALL a16 if not zero (Z = 0)
+        case 0xc5: PUSH();      break; // PUSH B
+        case 0xc6: ADI();       break; // ADI d8
+        case 0xc7: RST();       break; // RST 0
+        case 0xc8: Rccc();      break; // RZ = RET if zero (Z = 1)
+        case 0xc9: RET();       break; // RET
+        case 0xca: Jccc();      break; // JZ a16 = JMP a16 if zero (Z = 1)
+        case 0xcb: XXX();       break; // *JMP a16 (Alternative opcode, should not be used)
+        case 0xcc: Cccc();      break; // CZ a16 = CALL a16 if zero (Z = 1)
+        case 0xcd: CALL();      break; // CALL a16
+        case 0xce: ACI();       break; // ACI d8
+        case 0xcf: RST();       break; // RST 1
+
+        // 0xd0 - 0xdf
+        case 0xd0: Rccc();      break; // RNC = RET if no carry (CY = 0)
+        case 0xd1: POP();       break; // POP D
+        case 0xd2: Jccc();      break; // JNC a16 = JMP a16 if no carry (CY = 0)
+        case 0xd3: OUT();       break; // OUT d8 (port)
+        case 0xd4: Cccc();      break; // CNC a16 = CALL a16 if no carry (CY = 0)
+        case 0xd5: PUSH();      break; // PUSH D
+        case 0xd6: SUI();       break; // SUI d8
+        case 0xd7: RST();       break; // RST 2
+        case 0xd8: Rccc();      break; // RET if carry (CY = 1)
+        case 0xd9: XXX();       break; // *RET (Alternative opcode, should not be used)
+        case 0xda: Jccc();      break; // JC a16 = JMP a16 if carry (CY = 1)
+        case 0xdb: IN();        break; // IN d8/port
+        case 0xdc: Cccc();      break; // CC a16 = CALL a16 if carry (CY = 1)
+        case 0xdd: XXX();       break; // *CALL a16 (Alternative opcode, should not be used)
+        case 0xde: SBI();       break; // SBI d8
+        case 0xdf: RST();       break; // RST 3
+
+        // 0xe0 - 0xef
+        case 0xe0: Rccc();      break; // RPO = RET if parity odd (P = 0)
+        case 0xe1: POP();       break; // POP H
+        case 0xe2: Jccc();      break; // JPO a16 = JMP a16 if parity odd (P = 0)
+        case 0xe3: XTHL();      break; // XTHL
+        case 0xe4: Cccc();      break; // CPO a16 = CALL a16 if parity odd (P = 0)
+        case 0xe5: PUSH();      break; // PUSH H
+        case 0xe6: ANI();       break; // ANI d8
+        case 0xe7: RST();       break; // RST 4
+        case 0xe8: Rccc();      break; // RPE = RET if parity even (P = 1)
+        case 0xe9: PCHL();      break; // PCHL
+        case 0xea: Jccc();      break; // JPE a16 = JMP a16 if parity even (P = 1)
+        case 0xeb: XCHG();      break; // XCHG
+        case 0xec: Cccc();      break; // CPE a16 = CALL a16 if parity even (P = 1)
+        case 0xed: XXX();       break; // *CALL a16 (Alternative opcode, should not be used)
+        case 0xee: XRI();       break; // XRI d8
+        case 0xef: RST();       break; // RST 5
+
+        // 0xf0 - 0xff
+        case 0xf0: Rccc();      break; // RP = RET if plus (S = 0)
+        case 0xf1: POP();       break; // POP PSW
+        case 0xf2: Jccc();      break; // JP a16 = JMP a16 if plus (S = 0)
+        case 0xf3: DI();        break; // DI
+        case 0xf4: Cccc();      break; // CP a16 = CALL a16 if plus (S = 0)
+        case 0xf5: PUSH();      break; // PUSH PSW
+        case 0xf6: ORI();       break; // ORI d8
+        case 0xf7: RST();       break; // RST 6
+        case 0xf8: Rccc();      break; // RM = RET if minus (S = 1)
+        case 0xf9: SPHL();      break; // SPHL
+        case 0xfa: Jccc();      break; // JM a16 = JMP a16 if minus (S = 1)
+        case 0xfb: EI();        break; // EI
+        case 0xfc: Cccc();      break; // CM a16 = CALL a16 if minus (S = 1)
+        case 0xfd: XXX();       break; // *CALL a16 (Alternative opcode, should not be used)
+        case 0xfe: CPI();       break; // CPI d8
+        case 0xff: RST();       break; // RST 7
+        default  : XXX();       break;
+    }
+}
+
+// Same loop as Intel8080::execute, but dispatching through step().
+template <typename Trace>
+int Intel8080::executeSwitch(int numCycles, Trace& trace) {
+    cycles = numCycles;
+
+    while (cycles > 0) {
+        opcode = read(pc++);
+        if constexpr (Trace::enabled)
+            trace.record(*this, traceRecord());
+        step();
+    }
+
+    return cycles;
+}
+
+// Runs one decoded block. When the whole block fits in the remaining
+// budget the per-instruction budget check is skipped. A store into the block's
+// own pages ends the block early so self-modifying code is re-decoded before
+// it runs.
+template <typename Trace>
+inline void Intel8080::runBlock(const Block& block, Trace& trace) {
+    const DecodedOp* ops = blockCache->ops(block);
+    bool fitsBudget = cycles > (int) block.maxCycles;
+
+    for (int i = 0; i < block.count; i++) {
+        const DecodedOp& op = ops[i];
+        if constexpr (Trace::enabled) {
+            opcode = op.opcode;
+            pc = op.pc + 1;
+            trace.record(*this, traceRecord());
+        }
+        op.handler(this, op);
+
+        if (!fitsBudget && cycles <= 0) break;
+        if (op.writesMemory && blockCache->isStale(block, *memory)) break;
+    }
+}
+
+// Executes pre-decoded basic blocks from the block cache. Instruction fetch
+// and decode happen once per block instead of once per instruction, and each
+// instruction runs through its opDecoded handler.
+template <typename Trace>
+int Intel8080::executeBlocks(int numCycles, Trace& trace) {
+    if (!blockCache) blockCache = std::make_unique<BlockCache>(opDecodedHandlers());
+    cycles = numCycles;
+
+    while (cycles > 0)
+        runBlock(blockCache->lookup(pc, *memory), trace);
+
+    return cycles;
+}
+
+// Executes translated native code for hot blocks and interprets the rest.
+// Tracing needs to see every instruction, so traced runs stay interpreted.
+template <typename Trace>
+int Intel8080::executeJit(int numCycles, Trace& trace) {
+    if constexpr (Trace::enabled || !Jit::available()) {
+        return executeBlocks(numCycles, trace);
+    } else {
+        if (!blockCache) blockCache = std::make_unique<BlockCache>(opDecodedHandlers());
+        if (!jit) {
+            auto offset = [this](const void* field) {
+                return static_cast<int32_t>(static_cast<const char*>(field) - reinterpret_cast<const char*>(this));
+            };
+            jit = std::make_unique<Jit>(opThunks(), JitLayout{offset(reg8.data()), offset(&sp), offset(&pc),
+                                                              offset(&cycles), offset(&zspResult), offset(&zspLazy)});
+        }
+        cycles = numCycles;
+
+        while (cycles > 0) {
+            if (Jit::Code code = jit->find(pc, *memory)) {
+                code(this);
+                continue;
+            }
+            const Block& block = blockCache->lookup(pc, *memory);
+            if (jit->isHot(block.start))
+                jit->compile(block, blockCache->ops(block), *memory);
+            runBlock(block, trace);
+        }
+
+        return cycles;
+    }
+}
+
+// Executes code recompiled ahead of time from the ROM in memory and
+// interprets whatever the program does not cover. Like the JIT, traced runs
+// stay interpreted.
+template <typename Trace>
+int Intel8080::executeAot(int numCycles, Trace& trace) {
+    if (!aotAttached) {
+        aot = Aot::attach(*memory);
+        aotAttached = true;
+    }
+    if constexpr (Trace::enabled) {
+        return executeBlocks(numCycles, trace);
+    } else {
+        if (!aot) return executeBlocks(numCycles, trace);
+        if (!blockCache) blockCache = std::make_unique<BlockCache>(opDecodedHandlers());
+        cycles = numCycles;
+
+        while (cycles > 0) {
+            if (Aot::Code code = aot->find(pc, *memory)) {
+                code(this, *aot);
+                continue;
+            }
+            runBlock(blockCache->lookup(pc, *memory), trace);
+        }
+
+        return cycles;
+    }
+}
+
+// Flattening inlines step() with a constant opcode, which folds the switch
+// down to the single handler body.
+template <uint8_t OP>
+[[gnu::flatten]] int Intel8080::opThunk(Intel8080* cpu, uint32_t pc) {
+    cpu->opcode = OP;
+    cpu->pc = pc;
+    cpu->step();
+    return cpu->cycles;
+}
+
+// One thunk per opcode, indexed by opcode
+const std::array<Intel8080::Thunk, 256>& Intel8080::opThunks() {
+    static constexpr std::array<Thunk, 256> thunks = []<size_t... OP>(std::index_sequence<OP...>) {
+        return std::array<Thunk, 256>{ &opThunk<OP>... };
+    }(std::make_index_sequence<256>());
+    return thunks;
+}
+
+// Runs opcode OP for the block engine. Everything that can be known once per
+// decoded instruction comes from `op`: the immediate, address or target, the
+// register indices and the cost, so the only memory accesses left are the
+// instruction's own loads and stores (M operands, direct and indirect loads
+// and stores, the stack). Register-only ops are opInline, as in AOT code, and
+// the operand-free rest call their handlers.
+template <uint8_t OP>
+void Intel8080::opDecoded(Intel8080* cpu, const DecodedOp& op) {
+    using Mn = Mnemonic;
+    constexpr OpcodeInfo info = OPCODES[OP];
+    constexpr Mn mnemonic = info.mnemonic;
+    constexpr int taken = info.cycles - info.cyclesNotTaken;
+    const uint16_t next = op.pc + info.length;
+
+    if constexpr (inlinable(OP)) {
+        opInline<OP>(cpu, next, op.imm);
+        return;
+    }
+
+    cpu->cycles -= op.cycles;
+    cpu->pc = next;
+    if constexpr (info.flags & OpcodeInfo::UNDOCUMENTED) {
+        cpu->opcode = OP;
+        cpu->XXX();
+    } else if constexpr (mnemonic == Mn::MOV) {
+        cpu->writeReg8(op.regs[0], cpu->readReg8(op.regs[1]));
+    } else if constexpr (mnemonic == Mn::MVI) {
+        cpu->writeReg8(op.regs[0], static_cast<uint8_t>(op.imm));
+    } else if constexpr (mnemonic == Mn::INR) {
+        cpu->writeReg8(op.regs[0], cpu->aluInr(cpu->readReg8(op.regs[0])));
+    } else if constexpr (mnemonic == Mn::DCR) {
+        cpu->writeReg8(op.regs[0], cpu->aluDcr(cpu->readReg8(op.regs[0])));
+    } else if constexpr (mnemonic == Mn::ADD) {
+        cpu->aluAdd(cpu->readReg8(op.regs[0]), 0);
+    } else if constexpr (mnemonic == Mn::ADC) {
+        cpu->aluAdd(cpu->readReg8(op.regs[0]), cpu->GetFlag(CY));
+    } else if constexpr (mnemonic == Mn::SUB) {
+        cpu->aluSub(cpu->readReg8(op.regs[0]), 0);
+    } else if constexpr (mnemonic == Mn::SBB) {
+        cpu->aluSub(cpu->readReg8(op.regs[0]), cpu->GetFlag(CY));
+    } else if constexpr (mnemonic == Mn::ANA) {
+        cpu->aluAnd(cpu->readReg8(op.regs[0]));
+    } else if constexpr (mnemonic == Mn::XRA) {
+        cpu->aluXor(cpu->readReg8(op.regs[0]));
+    } else if constexpr (mnemonic == Mn::ORA) {
+        cpu->aluOr(cpu->readReg8(op.regs[0]));
+    } else if constexpr (mnemonic == Mn::CMP) {
+        cpu->aluCmp(cpu->readReg8(op.regs[0]));
+    } else if constexpr (mnemonic == Mn::LDA) {
+        cpu->reg8[A] = cpu->read(op.imm);
+    } else if constexpr (mnemonic == Mn::STA) {
+        cpu->write(op.imm, cpu->reg8[A]);
+    } else if constexpr (mnemonic == Mn::LHLD) {
+        cpu->write16RP(2, cpu->read16(op.imm));
+    } else if constexpr (mnemonic == Mn::SHLD) {
+        cpu->write16(op.imm, cpu->reg16_HL());
+    } else if constexpr (mnemonic == Mn::LDAX) {
+        cpu->reg8[A] = cpu->read(cpu->readRP(op.regs[0]));
+    } else if constexpr (mnemonic == Mn::STAX) {
+        cpu->write(cpu->readRP(op.regs[0]), cpu->reg8[A]);
+    } else if constexpr (mnemonic == Mn::DAD) {
+        uint32_t sum = (uint32_t) cpu->reg16_HL() + (uint32_t) cpu->readRP(op.regs[0]);
+        cpu->write16RP(2, static_cast<uint16_t>(sum));
+        cpu->SetFlag(CY, sum & 0xFFFF0000);
+    } else if constexpr (mnemonic == Mn::PUSH) {
+        cpu->push(cpu->readRP_PUSHPOP(op.regs[0]));
+    } else if constexpr (mnemonic == Mn::POP) {
+        cpu->write16RP_PUSHPOP(op.regs[0], cpu->pop());
+    } else if constexpr (mnemonic == Mn::IN) {
+        cpu->reg8[A] = cpu->inport(static_cast<uint8_t>(op.imm));
+    } else if constexpr (mnemonic == Mn::OUT) {
+        cpu->outport(static_cast<uint8_t>(op.imm), cpu->reg8[A]);
+    } else if constexpr (mnemonic == Mn::JMP) {
+        // Same idle-loop test as JMP(), whose pc is one past the opcode
+        if (cpu->skipping && op.imm <= op.pc && op.pc + 1 - op.imm <= IDLE_LOOP_BYTES) cpu->idleLoop(op.imm, op.pc);
+        cpu->pc = op.imm;
+    } else if constexpr (mnemonic == Mn::Jccc) {
+        if (cpu->TestCond(info.condition)) {
+            if (cpu->skipping && op.imm <= op.pc && op.pc + 1 - op.imm <= IDLE_LOOP_BYTES) cpu->idleLoop(op.imm, op.pc);
+            cpu->pc = op.imm;
+        } else if (cpu->skipping) {
+            cpu->idleExit(op.pc);
+        }
+    } else if constexpr (mnemonic == Mn::CALL) {
+        cpu->push(next);
+        cpu->pc = op.imm;
+    } else if constexpr (mnemonic == Mn::Cccc) {
+        if (cpu->TestCond(info.condition)) {
+            cpu->push(next);
+            cpu->pc = op.imm;
+            cpu->cycles -= taken;
+        }
+    } else if constexpr (mnemonic == Mn::RET) {
+        cpu->pc = cpu->pop();
+    } else if constexpr (mnemonic == Mn::Rccc) {
+        if (cpu->TestCond(info.condition)) {
+            cpu->pc = cpu->pop();
+            cpu->cycles -= taken;
+        }
+    } else if constexpr (mnemonic == Mn::RST) {
+        cpu->push(next);
+        cpu->pc = op.regs[0] << 3;  // Call n * 8
+    } else if constexpr (mnemonic == Mn::PCHL) {
+        cpu->PCHL();
+    } else if constexpr (mnemonic == Mn::HLT) {
+        cpu->HLT();                 // Steps pc back onto the HLT
+    } else if constexpr (mnemonic == Mn::DAA) {
+        cpu->DAA();
+    } else if constexpr (mnemonic == Mn::RLC) {
+        cpu->RLC();
+    } else if constexpr (mnemonic == Mn::RRC) {
+        cpu->RRC();
+    } else if constexpr (mnemonic == Mn::RAL) {
+        cpu->RAL();
+    } else if constexpr (mnemonic == Mn::RAR) {
+        cpu->RAR();
+    } else if constexpr (mnemonic == Mn::EI) {
+        cpu->EI();
+    } else if constexpr (mnemonic == Mn::DI) {
+        cpu->DI();
+    } else if constexpr (mnemonic == Mn::SPHL) {
+        cpu->SPHL();
+    } else if constexpr (mnemonic == Mn::XTHL) {
+        cpu->XTHL();
+    } else {
+        static_assert(inlinable(OP), "opDecoded has no case for this opcode");
+    }
+}
+
+// One decoded-op handler per opcode, indexed by opcode
+const std::array<DecodedOp::Handler, 256>& Intel8080::opDecodedHandlers() {
+    static constexpr std::array<DecodedOp::Handler, 256> handlers = []<size_t... OP>(std::index_sequence<OP...>) {
+        return std::array<DecodedOp::Handler, 256>{ &opDecoded<OP>... };
+    }(std::make_index_sequence<256>());
+    return handlers;
+}
+
+// Recompiled code calls the thunks from its own translation unit
+#define I8080_OP_THUNK(op)  template int Intel8080::opThunk<op>(Intel8080*, uint32_t);
+#define I8080_OP_THUNKS(hi) I8080_OP_THUNK(hi + 0x0) I8080_OP_THUNK(hi + 0x1) I8080_OP_THUNK(hi + 0x2) I8080_OP_THUNK(hi + 0x3) \
+                            I8080_OP_THUNK(hi + 0x4) I8080_OP_THUNK(hi + 0x5) I8080_OP_THUNK(hi + 0x6) I8080_OP_THUNK(hi + 0x7) \
+                            I8080_OP_THUNK(hi + 0x8) I8080_OP_THUNK(hi + 0x9) I8080_OP_THUNK(hi + 0xa) I8080_OP_THUNK(hi + 0xb) \
+                            I8080_OP_THUNK(hi + 0xc) I8080_OP_THUNK(hi + 0xd) I8080_OP_THUNK(hi + 0xe) I8080_OP_THUNK(hi + 0xf)
+I8080_OP_THUNKS(0x00) I8080_OP_THUNKS(0x10) I8080_OP_THUNKS(0x20) I8080_OP_THUNKS(0x30)
+I8080_OP_THUNKS(0x40) I8080_OP_THUNKS(0x50) I8080_OP_THUNKS(0x60) I8080_OP_THUNKS(0x70)
+I8080_OP_THUNKS(0x80) I8080_OP_THUNKS(0x90) I8080_OP_THUNKS(0xa0) I8080_OP_THUNKS(0xb0)
+I8080_OP_THUNKS(0xc0) I8080_OP_THUNKS(0xd0) I8080_OP_THUNKS(0xe0) I8080_OP_THUNKS(0xf0)
+#undef I8080_OP_THUNKS
+#undef I8080_OP_THUNK
+
+template int Intel8080::executeSwitch<NullTrace>(int, NullTrace&);
+template int Intel8080::executeSwitch<CountTrace>(int, CountTrace&);
+template int Intel8080::executeSwitch<RingTrace>(int, RingTrace&);
+template int Intel8080::executeSwitch<TextFileTrace>(int, TextFileTrace&);
+template int Intel8080::executeSwitch<BinaryFileTrace>(int, BinaryFileTrace&);
+
+template int Intel8080::executeBlocks<NullTrace>(int, NullTrace&);
+template int Intel8080::executeBlocks<CountTrace>(int, CountTrace&);
+template int Intel8080::executeBlocks<RingTrace>(int, RingTrace&);
+template int Intel8080::executeBlocks<TextFileTrace>(int, TextFileTrace&);
+template int Intel8080::executeBlocks<BinaryFileTrace>(int, BinaryFileTrace&);
+
+template int Intel8080::executeJit<NullTrace>(int, NullTrace&);
+template int Intel8080::executeJit<CountTrace>(int, CountTrace&);
+template int Intel8080::executeJit<RingTrace>(int, RingTrace&);
+template int Intel8080::executeJit<TextFileTrace>(int, TextFileTrace&);
+template int Intel8080::executeJit<BinaryFileTrace>(int, BinaryFileTrace&);
+
+template int Intel8080::executeAot<NullTrace>(int, NullTrace&);
+template int Intel8080::executeAot<CountTrace>(int, CountTrace&);
+template int Intel8080::executeAot<RingTrace>(int, RingTrace&);
+template int Intel8080::executeAot<TextFileTrace>(int, TextFileTrace&);
+template int Intel8080::executeAot<BinaryFileTrace>(int, BinaryFileTrace&);
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "cpu.hpp"
+
+// Intel8080::opInline, for code generated ahead of time (see aot.hpp).
+//
+// Where opThunk runs an opcode's handler, fetching its operand from memory
+// and keeping `opcode` and `pc` up to date, opInline gets the operand as a
+// constant and only writes pc, which the compiler drops between consecutive
+// inlined instructions. Register indices, cycle costs and the operation are
+// all taken from OPCODES at compile time, so each instantiation is a few
+// loads and stores. The operations themselves are the handlers' own helpers;
+// register pairs and the one-byte flag ops go through the out-of-line
+// helpers and handlers, which link-time optimisation inlines.
+template <uint8_t OP>
+inline int Intel8080::opInline(Intel8080* cpu, uint32_t next, uint16_t imm) {
+    static_assert(inlinable(OP), "opInline needs an inlinable opcode");
+    using Mn = Mnemonic;
+    constexpr OpcodeInfo info = OPCODES[OP];
+    constexpr Mn op = info.mnemonic;
+    constexpr uint8_t r = info.values[0];
+    // The ALU operand: the immediate, or register values[0]
+    const uint8_t value = info.operands[0] == Operand::Imm8 ? static_cast<uint8_t>(imm) : cpu->reg8[r & 7];
+
+    if constexpr (op == Mn::MOV) {
+        cpu->reg8[r] = cpu->reg8[info.values[1]];
+    } else if constexpr (op == Mn::MVI) {
+        cpu->reg8[r] = static_cast<uint8_t>(imm);
+    } else if constexpr (op == Mn::INR) {
+        cpu->reg8[r] = cpu->aluInr(cpu->reg8[r]);
+    } else if constexpr (op == Mn::DCR) {
+        cpu->reg8[r] = cpu->aluDcr(cpu->reg8[r]);
+    } else if constexpr (op == Mn::LXI) {
+        cpu->write16RP(r, imm);
+    } else if constexpr (op == Mn::INX) {
+        cpu->write16RP(r, cpu->readRP(r) + 1);
+    } else if constexpr (op == Mn::DCX) {
+        cpu->write16RP(r, cpu->readRP(r) - 1);
+    } else if constexpr (op == Mn::ADD || op == Mn::ADI) {
+        cpu->aluAdd(value, 0);
+    } else if constexpr (op == Mn::ADC || op == Mn::ACI) {
+        cpu->aluAdd(value, cpu->GetFlag(CY));
+    } else if constexpr (op == Mn::SUB || op == Mn::SUI) {
+        cpu->aluSub(value, 0);
+    } else if constexpr (op == Mn::SBB || op == Mn::SBI) {
+        cpu->aluSub(value, cpu->GetFlag(CY));
+    } else if constexpr (op == Mn::ANA || op == Mn::ANI) {
+        cpu->aluAnd(value);
+    } else if constexpr (op == Mn::XRA || op == Mn::XRI) {
+        cpu->aluXor(value);
+    } else if constexpr (op == Mn::ORA || op == Mn::ORI) {
+        cpu->aluOr(value);
+    } else if constexpr (op == Mn::CMP || op == Mn::CPI) {
+        cpu->aluCmp(value);
+    } else if constexpr (op == Mn::CMA) {
+        cpu->CMA();
+    } else if constexpr (op == Mn::CMC) {
+        cpu->CMC();
+    } else if constexpr (op == Mn::STC) {
+        cpu->STC();
+    } else if constexpr (op == Mn::XCHG) {
+        cpu->XCHG();
+    }
+
+    cpu->cycles -= info.cycles;
+    cpu->pc = next;
+    return cpu->cycles;
+}
@@ -1,13 +1,18 @@
 #include "platform.hpp"
+#include "romset.hpp"
 
-Platform::Platform() : prevTemp(), currTemp() {
-    // Initialize the CPU, Display, and Audio for the emulator
-    cpu = new Intel8080();
+#include <thread>
+
+Platform::Platform() : pacer(FramePacer::HZ_60), movieMode(MovieMode::None), request(Request::None), speed(1.0), rewinding(false),
+                       inputs(IOPorts::IN_PORT1_IDLE), running(false), prevTemp(), currTemp() {
+    // Initialize the machine (CPU, memory, I/O), Display, and Audio for the emulator
+    machine = new Machine();
     display = new Display();
     audio = new Audio();
 
-    // Load the Space Invaders game file into memory
-    bool loadSuccess = cpu->load("invaders", 0);
+    // Load the Space Invaders ROM chips (or their cached combined image) into memory
+    std::vector<uint8_t> rom;
+    bool loadSuccess = loadRomSet(SPACE_INVADERS, ".", rom) && machine->load(rom);
     if (!loadSuccess) {
         std::cout << "Could not load file." << std::endl;
         exit(1); // Exit if the file loading fails
@@ -28,9 +33,8 @@ Platform::Platform() : prevTemp(), currTemp() {
 }
 
 
-// This function is the heart of the emulation platform. It sets up a system clock to keep track
-// of the emulation's timing and enters a loop that keeps the emulation running. Inside this loop,
-// we're balancing time to ensure a smooth frame rate, approximately 60 fps.
+// This function is the heart of the emulation platform. It keeps the emulation running, paced
+// to the 60 Hz video refresh by a FramePacer, until the window is closed.
 //
 // Space Invaders originally ran on hardware that operated at a clock speed of approximately 2 MHz
 // (2,000,000 cycles per second). The game was designed to maintain a consistent frame rate,
@@ -42,41 +46,139 @@ Platform::Platform() : prevTemp(), currTemp() {
 // Since each frame is divided into two halves, each half would be approximately
 // 33,333 / 2 ≈ 16,666 cycles/half-frame.
 //
-// In each cycle, we're executing CPU instructions, handling screen interrupts for half-screen and
-// full-screen updates, and updating the display. Additionally, this loop takes care of audio
-// processing and user input handling, more or less ensuring that our emulation responds just
-// like the original hardware would.
+// The work is split across three threads so that none can hold up another:
+//  - the emulation thread sleeps until the next frame is due and executes CPU instructions for
+//    it, handling screen interrupts for half-screen and full-screen updates (Machine fires them
+//    at exact cycle timestamps, carrying any overshoot into the next frame). If it fell behind,
+//    the missed frames are emulated back to back. Each finished frame's video RAM is published
+//    through a lock-free triple buffer. Every frame is also recorded in a RewindBuffer, and while
+//    Backspace is held frames are stepped back through it instead of run.
+//  - the audio thread plays the sound port changes the CPU pushed onto IOPorts::soundEvents.
+//  - the main thread, which owns the window, sleeps until a frame is published, then handles
+//    user input and draws it, so a slow texture upload or vsync wait only ever delays the picture.
 void Platform::run() {
-    // Initialize system clock for tracking emulation time
-    sf::Clock systemTimeClock;
-    sf::Time elapsedTime = sf::Time::Zero;
-    systemTimeClock.restart();
-
     std::cout << "Commencing emulation..." << std::endl;
+    running = true;
+    std::thread emulationThread(&Platform::emulate, this);
+    std::thread audioThread(&Platform::playAudio, this);
+
     while (display->window.isOpen()) {
-        elapsedTime += systemTimeClock.restart();   // update elapsed time
+        handleInput(display->window);
+        frames.wait();                              // woken as soon as the emulation thread publishes
+        display->draw(frames.readBuffer());         // render and display window
+    }
 
-        // Define frame duration (approximately 60 frames per second)
-        const int timePerFrameMs = 17; // 1000 ms / 60 fps ≈ 17 ms
+    running = false;
+    emulationThread.join();
+    audioThread.join();
 
-        // Process CPU execution and interrupts at each frame
-        if (elapsedTime.asMilliseconds() > timePerFrameMs) {
-            elapsedTime = sf::Time::Zero;   // reset elapsed time for next frame
+    FramePacer::Stats stats = pacer.stats();
+    printf("Frame time: mean %.3f ms, min %.3f ms, max %.3f ms, jitter %.3f ms (%llu frames, %llu late, %llu dropped)\n",
+           stats.meanMs, stats.minMs, stats.maxMs, stats.jitterMs,
+           (unsigned long long) stats.frames, (unsigned long long) stats.late, (unsigned long long) stats.dropped);
+    if (uint64_t overflows = machine->cpu.ioPorts->soundEvents.overflowCount())
+        std::cout << "Sound events dropped (ring full): " << overflows << std::endl;
+    if (movieMode == MovieMode::Recording && movie.save(moviePath))
+        std::cout << "Recorded " << movie.frames() << " frames to " << moviePath << std::endl;
+    std::cout << "Quit successfully." << std::endl;
+}
 
-            cpu->execute(16666);            // execute CPU cycles for half a screen update
-            cpu->interrupt(1);              // generate half-screen interrupt (RST 1)
+// Emulation thread
+void Platform::emulate() {
+    pacer.reset();                              // don't count start-up time as missed frames
+    while (running.load(std::memory_order_relaxed)) {
+        handleRequest();
+        pacer.setSpeed(speed.load(std::memory_order_relaxed));
+        int framesDue = pacer.wait();           // sleep until the next frame deadline
+        for (int i = 0; i < framesDue; i++) {
+            if (rewinding.load(std::memory_order_relaxed)) {
+                if (rewind.stepBack(snapshot)) {    // back to the end of the previous frame
+                    machine->restore(snapshot);
+                    if (movieMode == MovieMode::Recording)
+                        movie.truncate(machine->frameCount());
+                }
+            } else {
+                runFrame();
+                machine->save(snapshot);
+                rewind.push(snapshot);
+            }
+        }
+
+        machine->captureVideo(frames.writeBuffer());
+        frames.publish();
+    }
+}
+
+// Runs one frame on the emulation thread. Inputs are latched into the machine
+// before it, from the movie when replaying and from the keyboard otherwise,
+// so that the frame's outcome depends only on its starting state and inputs.
+void Platform::runFrame() {
+    uint64_t frame = machine->frameCount();
+    bool replaying = movieMode == MovieMode::Replaying && frame < movie.frames();
+    uint8_t frameInputs = replaying ? movie.inputs(frame) : inputs.load(std::memory_order_relaxed);
+    machine->setInputs(frameInputs);
 
-            cpu->execute(16666);            // execute CPU cycles for the remaining half
-            cpu->interrupt(2);              // generate full-screen interrupt (RST 2)
+    machine->runFrame();                    // execute CPU cycles up to VBLANK, raising RST 1 and RST 2 on time
 
-            display->draw(*cpu);            // render and display window
+    if (movieMode == MovieMode::Recording) {
+        movie.record(frameInputs, machine->ramHash());
+    } else if (replaying) {
+        if (machine->ramHash() != movie.ramHash(frame)) {
+            std::cerr << "Replay diverged at frame " << frame << ", back to the keyboard" << std::endl;
+            movieMode = MovieMode::None;
+        } else if (frame + 1 == movie.frames()) {
+            std::cout << "Replay finished, every frame matched" << std::endl;
+            movieMode = MovieMode::None;
         }
+    }
+}
+
+void Platform::recordMovie(const std::string& filePath) {
+    movie.start(machine->romHash());
+    movieMode = MovieMode::Recording;
+    moviePath = filePath;
+}
 
-        // Handle audio and user input
-        handleAudio(*cpu->ioPorts);
-        handleInput(display->window, *cpu->ioPorts);
+bool Platform::replayMovie(const std::string& filePath) {
+    if (!movie.load(filePath)) return false;
+    if (movie.romHash() != machine->romHash()) {
+        std::cerr << "Movie was recorded with a different ROM: " << filePath << std::endl;
+        return false;
+    }
+    movieMode = MovieMode::Replaying;
+    moviePath = filePath;
+    return true;
+}
+
+// Runs on the emulation thread, between frames
+void Platform::handleRequest() {
+    switch (request.exchange(Request::None, std::memory_order_acquire)) {
+        case Request::SaveState:
+            if (machine->saveState(STATE_FILE)) std::cout << "Saved state to " << STATE_FILE << std::endl;
+            break;
+        case Request::LoadState:
+            if (movieMode != MovieMode::None)  // the movie could not account for the jump
+                std::cerr << "Cannot load a state while a movie is recording or replaying" << std::endl;
+            else if (machine->loadState(STATE_FILE)) std::cout << "Loaded state from " << STATE_FILE << std::endl;
+            break;
+        case Request::None:
+            break;
+    }
+}
+
+void Platform::setButton(Button button, bool pressed) {
+    if (pressed)
+        inputs.fetch_or(1 << static_cast<uint8_t>(button), std::memory_order_relaxed);
+    else
+        inputs.fetch_and(~(1 << static_cast<uint8_t>(button)), std::memory_order_relaxed);
+}
+
+// Audio thread
+void Platform::playAudio() {
+    while (running.load(std::memory_order_relaxed)) {
+        handleAudio(*machine->cpu.ioPorts);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
     }
-    std::cout << "Quit successfully." << std::endl;
 }
 
 // Processes user input events such as keyboard presses and releases,
@@ -92,7 +194,10 @@ void Platform::run() {
 // bit 6 = 1P right (1 if pressed)
 // bit 7 = Not connected
 // Source: http://computerarcheology.com/Arcade/SpaceInvaders/Hardware.html
-void Platform::handleInput(sf::RenderWindow& gameWindow, IOPorts& gamePorts) {
+//
+// Buttons only update `inputs`; the emulation thread latches it into the
+// machine at the next frame boundary (see runFrame).
+void Platform::handleInput(sf::RenderWindow& gameWindow) {
     using sf::Keyboard;
 
     sf::Event inputEvent;
@@ -103,27 +208,35 @@ void Platform::handleInput(sf::RenderWindow& gameWindow, IOPorts& gamePorts) {
         // Handle key press events
         if (inputEvent.type == sf::Event::KeyPressed) {
             switch (inputEvent.key.code) {
-                case Keyboard::Escape:  gameWindow.close();               break; // Quit
-                case Keyboard::C:       gamePorts.setInPort1Bit(0, true); break; // Coin inserted
-                case Keyboard::Num2:    gamePorts.setInPort1Bit(1, true); break; // Player 2 Start
-                case Keyboard::Enter:   gamePorts.setInPort1Bit(2, true); break; // Player 1 Start
-                case Keyboard::Space:   gamePorts.setInPort1Bit(4, true); break; // Shoot button
-                case Keyboard::Left:    gamePorts.setInPort1Bit(5, true); break; // Move left
-                case Keyboard::Right:   gamePorts.setInPort1Bit(6, true); break; // Move right
-                default:                                                  break; // Do nothing
+                case Keyboard::Escape:    gameWindow.close();                break; // Quit
+                case Keyboard::C:         setButton(Button::Coin, true);     break; // Coin inserted
+                case Keyboard::Num2:      setButton(Button::P2Start, true);  break; // Player 2 Start
+                case Keyboard::Enter:     setButton(Button::P1Start, true);  break; // Player 1 Start
+                case Keyboard::Space:     setButton(Button::Fire, true);     break; // Shoot button
+                case Keyboard::Left:      setButton(Button::Left, true);     break; // Move left
+                case Keyboard::Right:     setButton(Button::Right, true);    break; // Move right
+                case Keyboard::Tab:       speed = FAST_FORWARD;              break; // Fast-forward while held
+                case Keyboard::LShift:    speed = SLOW_MOTION;               break; // Slow motion while held
+                case Keyboard::F5:        request = Request::SaveState;      break; // Save state
+                case Keyboard::F9:        request = Request::LoadState;      break; // Load state
+                case Keyboard::Backspace: rewinding = true;                  break; // Rewind while held
+                default:                                                     break; // Do nothing
             }
         }
 
         // Handle key release events
         if (inputEvent.type == sf::Event::KeyReleased) {
             switch (inputEvent.key.code) {
-                case Keyboard::C:       gamePorts.setInPort1Bit(0, false); break; // Coin released
-                case Keyboard::Num2:    gamePorts.setInPort1Bit(1, false); break; // Player 2 Start released
-                case Keyboard::Enter:   gamePorts.setInPort1Bit(2, false); break; // Player 1 Start released
-                case Keyboard::Space:   gamePorts.setInPort1Bit(4, false); break; // Shoot button released
-                case Keyboard::Left:    gamePorts.setInPort1Bit(5, false); break; // Move left released
-                case Keyboard::Right:   gamePorts.setInPort1Bit(6, false); break; // Move right released
-                default:                                                   break; // Do nothing
+                case Keyboard::C:         setButton(Button::Coin, false);    break; // Coin released
+                case Keyboard::Num2:      setButton(Button::P2Start, false); break; // Player 2 Start released
+                case Keyboard::Enter:     setButton(Button::P1Start, false); break; // Player 1 Start released
+                case Keyboard::Space:     setButton(Button::Fire, false);    break; // Shoot button released
+                case Keyboard::Left:      setButton(Button::Left, false);    break; // Move left released
+                case Keyboard::Right:     setButton(Button::Right, false);   break; // Move right released
+                case Keyboard::Tab:                                                 // Back to real time
+                case Keyboard::LShift:    speed = 1.0;                       break;
+                case Keyboard::Backspace: rewinding = false;                 break; // Resume from here
+                default:                                                     break; // Do nothing
             }
         }
     }
@@ -154,11 +267,12 @@ void Platform::handleInput(sf::RenderWindow& gameWindow, IOPorts& gamePorts) {
 // bit 7= NC (not wired)
 // Source: http://computerarcheology.com/Arcade/SpaceInvaders/Hardware.html
 void Platform::handleAudio(IOPorts& gamePorts) {
-    while (!gamePorts.playNext.empty()) {
-        if (get<0>(gamePorts.playNext.front()) == 3) {
+    SoundEvent event;
+    while (gamePorts.soundEvents.pop(event)) {
+        if (event.port == 3) {
             // Play sounds based on IOPorts::outPort3
-            prevTemp = get<1>(gamePorts.playNext.front());
-            currTemp = get<2>(gamePorts.playNext.front());
+            prevTemp = event.previous;
+            currTemp = event.current;
 
             if (!(prevTemp & (1 << 0)) && (currTemp & (1 << 0)))        audio->play("ufo_highpitch");
             else if ((prevTemp & (1 << 0)) && !(currTemp & (1 << 0)))   audio->stop("ufo_highpitch");
@@ -173,8 +287,8 @@ void Platform::handleAudio(IOPorts& gamePorts) {
             else if ((prevTemp & (1 << 3)) && !(currTemp & (1 << 3)))   audio->stop("invaderkilled");
         } else {
             // Play sounds based on IOPorts::outPort5
-            prevTemp = get<1>(gamePorts.playNext.front());
-            currTemp = get<2>(gamePorts.playNext.front());
+            prevTemp = event.previous;
+            currTemp = event.current;
 
             if (!(prevTemp & (1 << 0)) && (currTemp & (1 << 0)))        audio->play("fastinvader1");
             else if ((prevTemp & (1 << 0)) && !(currTemp & (1 << 0)))   audio->stop("fastinvader1");
@@ -191,6 +305,5 @@ void Platform::handleAudio(IOPorts& gamePorts) {
             if (!(prevTemp & (1 << 4)) && (currTemp & (1 << 4)))        audio->play("ufo_lowpitch");
             else if ((prevTemp & (1 << 4)) && !(currTemp & (1 << 4)))   audio->stop("ufo_lowpitch");
         }
-        gamePorts.playNext.pop();
     }
 }
\ No newline at end of file
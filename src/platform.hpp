@@ -1,20 +1,56 @@
 #pragma once
 
-#include "cpu.hpp"
+#include "machine.hpp"
 #include "display.hpp"
 #include "audio.hpp"
+#include "framepacer.hpp"
+#include "movie.hpp"
+#include "rewind.hpp"
+#include "triplebuffer.hpp"
+
+#include <atomic>
 
 class Platform {
 public:
     Platform();
     void run();
+    void recordMovie(const std::string& filePath);     // Record the session from power-on, written on exit
+    bool replayMovie(const std::string& filePath);     // Play a recorded session back instead of the keyboard
 
 private:
-    Intel8080*   cpu;
+    Machine*     machine;
     Display*     display;
     Audio*       audio;
+    FramePacer   pacer;                 // Used by the emulation thread only
+    RewindBuffer rewind;                // Ditto
+    Snapshot     snapshot;              // Ditto, working copy for recording and rewinding
+
+    enum class MovieMode : uint8_t { None, Recording, Replaying };
+    Movie        movie;                 // Set up before run(), then used by the emulation thread only
+    MovieMode    movieMode;
+    std::string  moviePath;
+
+    // Machine operations the main thread asks the emulation thread to carry
+    // out between frames, so the machine is only ever touched from one thread
+    enum class Request : uint8_t { None, SaveState, LoadState };
+
+    TripleBuffer<VideoFrame> frames;    // Emulation thread -> main thread
+    std::atomic<Request>     request;   // Main thread -> emulation thread
+    std::atomic<double>      speed;     // Speed multiplier requested from the input handler
+    std::atomic<bool>        rewinding; // Backspace held: step back a frame per frame instead of running
+    std::atomic<uint8_t>     inputs;    // Port 1 as the keyboard has it, latched into the machine each frame
+    std::atomic<bool>        running;
+
+    static constexpr double FAST_FORWARD = 4.0;     // Speed multipliers while Tab / Left Shift is held
+    static constexpr double SLOW_MOTION  = 0.25;
+    static constexpr const char* STATE_FILE = "invaders.state";    // F5 saves, F9 loads
 
-    void handleInput(sf::RenderWindow& gameWindow, IOPorts& gamePorts);
+    void emulate();
+    void handleRequest();
+    void runFrame();
+    void setButton(Button button, bool pressed);
+    void playAudio();
+    void handleInput(sf::RenderWindow& gameWindow);
     void handleAudio(IOPorts& gamePorts);
 
 private:
@@ -0,0 +1,129 @@
+#include "rewind.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable_v<Snapshot>, "snapshots are stored as raw bytes");
+static_assert(sizeof(Snapshot) <= UINT16_MAX, "run lengths are 16-bit");
+
+constexpr size_t SNAPSHOT_BYTES = sizeof(Snapshot);
+constexpr size_t MIN_ZERO_RUN   = 4;    // Shorter gaps between differing bytes stay inside a literal
+
+// Deltas are a sequence of (u16 zero run, u16 literal length, literal bytes)
+// covering the snapshot, where the zero run counts bytes equal to the
+// keyframe's and the literal holds the XOR of the ones that differ
+static void put16(std::vector<uint8_t>& out, size_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+static size_t get16(const uint8_t* in) {
+    return in[0] | in[1] << 8;
+}
+
+static void encodeDelta(const uint8_t* current, const uint8_t* base, std::vector<uint8_t>& out) {
+    size_t pos = 0;
+    while (pos < SNAPSHOT_BYTES) {
+        size_t zeros = 0;
+        while (pos + zeros < SNAPSHOT_BYTES && current[pos + zeros] == base[pos + zeros])
+            zeros++;
+        pos += zeros;
+
+        // The literal ends at the first run of MIN_ZERO_RUN equal bytes, which
+        // (like any equal bytes at the very end) go to the next zero run
+        size_t literal = 0, equal = 0;
+        while (pos + literal < SNAPSHOT_BYTES && equal < MIN_ZERO_RUN) {
+            equal = current[pos + literal] == base[pos + literal] ? equal + 1 : 0;
+            literal++;
+        }
+        literal -= equal;
+
+        put16(out, zeros);
+        put16(out, literal);
+        for (size_t i = 0; i < literal; i++)
+            out.push_back(current[pos + i] ^ base[pos + i]);
+        pos += literal;
+    }
+}
+
+static void applyDelta(const std::vector<uint8_t>& delta, uint8_t* target) {
+    size_t pos = 0;
+    for (size_t at = 0; at + 4 <= delta.size();) {
+        pos += get16(&delta[at]);
+        size_t literal = get16(&delta[at + 2]);
+        at += 4;
+        for (size_t i = 0; i < literal; i++)
+            target[pos + i] ^= delta[at + i];
+        pos += literal;
+        at += literal;
+    }
+}
+
+RewindBuffer::RewindBuffer(size_t capacity)
+        : entries(std::max(capacity, 2 * KEYFRAME_INTERVAL)), oldest(), count(), sinceKeyframe() {}
+
+void RewindBuffer::push(const Snapshot& snapshot) {
+    if (count == entries.size()) dropOldest();
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&snapshot);
+    Entry& entry = entries[(oldest + count) % entries.size()];
+    count++;
+    entry.data.clear();
+    entry.keyframe = count == 1 || sinceKeyframe == KEYFRAME_INTERVAL - 1;
+    if (entry.keyframe) {
+        entry.data.insert(entry.data.end(), bytes, bytes + SNAPSHOT_BYTES);
+        keyframe = entry.data;
+        sinceKeyframe = 0;
+    } else {
+        encodeDelta(bytes, keyframe.data(), entry.data);
+        sinceKeyframe++;
+    }
+}
+
+bool RewindBuffer::stepBack(Snapshot& snapshot) {
+    if (count < 2) return false;
+
+    bool droppedKeyframe = entries[index(0)].keyframe;
+    count--;
+    if (droppedKeyframe) {
+        // New deltas are relative to the keyframe before it
+        size_t age = 0;
+        while (!entries[index(age)].keyframe) age++;
+        keyframe = entries[index(age)].data;
+        sinceKeyframe = age;
+    } else {
+        sinceKeyframe--;
+    }
+
+    decode(0, snapshot);
+    return true;
+}
+
+void RewindBuffer::clear() {
+    oldest = count = sinceKeyframe = 0;
+}
+
+size_t RewindBuffer::bytes() const {
+    size_t total = 0;
+    for (size_t age = 0; age < count; age++)
+        total += entries[index(age)].data.size();
+    return total;
+}
+
+// Drops the oldest keyframe together with the deltas that depend on it
+void RewindBuffer::dropOldest() {
+    do {
+        oldest = (oldest + 1) % entries.size();
+        count--;
+    } while (count > 0 && !entries[oldest].keyframe);
+}
+
+void RewindBuffer::decode(size_t age, Snapshot& snapshot) const {
+    size_t key = age;
+    while (!entries[index(key)].keyframe) key++;
+
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(&snapshot);
+    std::memcpy(bytes, entries[index(key)].data.data(), SNAPSHOT_BYTES);
+    if (key != age) applyDelta(entries[index(age)].data, bytes);
+}
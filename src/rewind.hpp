@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "machine.hpp"
+
+// Per-frame history of machine snapshots for stepping backwards in time.
+//
+// Every KEYFRAME_INTERVAL-th snapshot is stored whole; the ones in between
+// are stored as the XOR of the snapshot with the last keyframe, run-length
+// encoded. Between two nearby frames only a few hundred bytes of RAM differ,
+// so the XOR is almost all zeros and a frame costs a few hundred bytes rather
+// than 8 KB (let alone a 64 KB copy of the address space).
+//
+// The ring holds up to `capacity` frames. Once full, recording a frame drops
+// the oldest one, and with it any deltas whose keyframe was dropped. Entry
+// buffers are reused, so once the ring has wrapped recording stops allocating.
+class RewindBuffer {
+public:
+    static constexpr size_t DEFAULT_CAPACITY  = 3 * 60 * 60;   // Three minutes at 60 frames per second
+    static constexpr size_t KEYFRAME_INTERVAL = 60;
+
+    explicit RewindBuffer(size_t capacity = DEFAULT_CAPACITY);
+
+    void   push(const Snapshot& snapshot);     // Record the newest frame
+    bool   stepBack(Snapshot& snapshot);       // Drop the newest frame and decode the one before it; false if none
+    void   clear();
+
+    size_t frames() const                      { return count; }
+    size_t bytes() const;                      // Encoded size of the frames held
+
+private:
+    struct Entry {
+        bool                 keyframe;
+        std::vector<uint8_t> data;             // Raw snapshot bytes, or the RLE-coded XOR against the keyframe
+    };
+
+    std::vector<Entry>   entries;              // Ring of `count` frames starting at `oldest`
+    size_t               oldest;
+    size_t               count;
+    size_t               sinceKeyframe;        // Frames recorded since the newest keyframe
+    std::vector<uint8_t> keyframe;             // Bytes of the newest keyframe, the base of new deltas
+
+    size_t index(size_t age) const             { return (oldest + count - 1 - age) % entries.size(); }  // 0 = newest
+    void   dropOldest();
+    void   decode(size_t age, Snapshot& snapshot) const;
+};
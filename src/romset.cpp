@@ -0,0 +1,197 @@
+#include "romset.hpp"
+#include "memory.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define I8080_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const RomSet SPACE_INVADERS = {"invaders", {
+    {"invaders.h", 0x0000, 0x0800, 0x734F5AD8},
+    {"invaders.g", 0x0800, 0x0800, 0x6BFACA4A},
+    {"invaders.f", 0x1000, 0x0800, 0x0CCEAD96},
+    {"invaders.e", 0x1800, 0x0800, 0x14E538B0},
+}};
+
+// Reflected CRC-32 (polynomial 0xEDB88320) as used by zip and MAME
+constexpr std::array<uint32_t, 256> CRC32_TABLE = [] {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+            crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        table[i] = crc;
+    }
+    return table;
+}();
+
+uint32_t crc32(const uint8_t* data, size_t size) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; i++)
+        crc = CRC32_TABLE[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// A whole file mapped read-only, or read into memory where mmap is missing.
+// Opening quietly fails, so a missing optional file (the cache) is no error.
+namespace {
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filePath) {
+#if I8080_MMAP
+        int fd = open(filePath.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                bytes = static_cast<const uint8_t*>(mapping);
+                length = static_cast<size_t>(info.st_size);
+            }
+        }
+        close(fd);
+#else
+        std::ifstream file(filePath, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        bytes = contents.data();
+        length = file.is_open() ? contents.size() : 0;
+#endif
+    }
+
+    ~MappedFile() {
+#if I8080_MMAP
+        if (bytes) munmap(const_cast<uint8_t*>(bytes), length);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool           isOpen() const   { return length > 0; }
+    const uint8_t* data() const     { return bytes; }
+    size_t         size() const     { return length; }
+
+private:
+    const uint8_t* bytes = nullptr;
+    size_t         length = 0;
+#if !I8080_MMAP
+    std::vector<uint8_t> contents;
+#endif
+};
+}
+
+static size_t imageSize(const RomSet& set) {
+    size_t size = 0;
+    for (const RomChip& chip : set.chips)
+        size = std::max<size_t>(size, chip.address + chip.size);
+    return size;
+}
+
+static std::string hex(uint32_t value, int digits = 8) {
+    char text[9];
+    snprintf(text, sizeof(text), "%0*X", digits, value);
+    return text;
+}
+
+// Checks every chip's region of a combined image; reports the first bad one
+// when `filePath` is given
+static bool verifyImage(const RomSet& set, const uint8_t* image, size_t size, const char* filePath) {
+    if (size != imageSize(set)) {
+        if (filePath) std::cerr << filePath << ": " << size << " bytes, expected " << imageSize(set) << std::endl;
+        return false;
+    }
+    for (const RomChip& chip : set.chips) {
+        uint32_t crc = crc32(image + chip.address, chip.size);
+        if (crc != chip.crc32) {
+            if (filePath)
+                std::cerr << filePath << ": region " << hex(chip.address, 4) << " has CRC32 " << hex(crc)
+                          << ", expected " << chip.file << " (" << hex(chip.crc32) << ")" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool loadManifest(const std::string& filePath, RomSet& set) {
+    std::ifstream file(filePath);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open ROM manifest: " << filePath << std::endl;
+        return false;
+    }
+
+    std::string base = filePath.substr(filePath.find_last_of("/\\") + 1);
+    set.name = base.substr(0, base.find('.'));
+    set.chips.clear();
+
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); lineNumber++) {
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+        std::istringstream fields(line);
+        RomChip chip{};
+        uint32_t address, size;
+        if (!(fields >> chip.file >> std::hex >> address >> size >> chip.crc32) ||
+            size == 0 || address + size > RAM_SIZE) {
+            std::cerr << filePath << ":" << lineNumber << ": expected \"<file> <address> <size> <crc32>\"" << std::endl;
+            return false;
+        }
+        chip.address = static_cast<uint16_t>(address);
+        chip.size = static_cast<uint16_t>(size);
+        set.chips.push_back(chip);
+    }
+    return true;
+}
+
+bool loadRomSet(const RomSet& set, const std::string& directory, std::vector<uint8_t>& image) {
+    std::string prefix = directory.empty() ? "" : directory + "/";
+
+    std::string cachePath = prefix + set.name + ".rom";
+    {
+        MappedFile cache(cachePath);
+        if (cache.isOpen() && verifyImage(set, cache.data(), cache.size(), nullptr)) {
+            image.assign(cache.data(), cache.data() + cache.size());
+            return true;
+        }
+    }
+
+    image.assign(imageSize(set), 0);
+    for (const RomChip& chip : set.chips) {
+        std::string chipPath = prefix + chip.file;
+        MappedFile file(chipPath);
+        if (!file.isOpen()) {
+            // A set that was already combined into a single file
+            std::string combinedPath = prefix + set.name;
+            MappedFile combined(combinedPath);
+            if (combined.isOpen() && verifyImage(set, combined.data(), combined.size(), combinedPath.c_str())) {
+                image.assign(combined.data(), combined.data() + combined.size());
+                return true;
+            }
+            std::cerr << "Failed to open ROM: " << chipPath << std::endl;
+            return false;
+        }
+
+        uint32_t crc = crc32(file.data(), file.size());
+        if (file.size() != chip.size || crc != chip.crc32) {
+            std::cerr << chipPath << ": " << file.size() << " bytes with CRC32 " << hex(crc)
+                      << ", expected " << chip.size << " bytes with CRC32 " << hex(chip.crc32) << std::endl;
+            return false;
+        }
+        std::copy(file.data(), file.data() + file.size(), image.begin() + chip.address);
+    }
+
+    // Best effort: without the cache the next start just reads the chips again
+    std::ofstream cache(cachePath, std::ios::binary);
+    cache.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+    return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The Space Invaders program lives in four 2 KB chips. Dumps come as one
+// file per chip, and gluing them together in the wrong order gives an image
+// that loads fine and then crashes somewhere in the attract mode. A RomSet
+// lists each chip's file, address and CRC32 so that every byte is checked
+// before the machine starts.
+struct RomChip {
+    std::string file;       // Relative to the ROM directory
+    uint16_t    address;
+    uint16_t    size;
+    uint32_t    crc32;
+};
+
+struct RomSet {
+    std::string          name;      // Also names the combined image, see loadRomSet
+    std::vector<RomChip> chips;
+};
+
+// invaders.h/.g/.f/.e at 0x0000/0x0800/0x1000/0x1800
+// Source: MAME's Midway 8080 driver (mw8080bw.cpp)
+extern const RomSet SPACE_INVADERS;
+
+// Reads a ROM set description, one chip per line; '#' starts a comment:
+//   invaders.h  0000  0800  734f5ad8      (file, address, size, CRC32, all hex)
+// The set is named after the manifest file without its extension.
+bool loadManifest(const std::string& filePath, RomSet& set);
+
+// Builds the set's image (address 0 up to the end of the last chip) from the
+// files in `directory`, each mapped read-only and checked against its CRC32.
+//
+// The checked image is cached as <name>.rom next to the chips and used on the
+// next start instead of opening every chip (it is re-checked, so a stale or
+// damaged cache just falls back to the chips). Without the chip files, an
+// already combined image named <name> is accepted if every region matches.
+bool loadRomSet(const RomSet& set, const std::string& directory, std::vector<uint8_t>& image);
+
+uint32_t crc32(const uint8_t* data, size_t size);
@@ -0,0 +1,51 @@
+#include "scheduler.hpp"
+
+Scheduler::EventId Scheduler::schedule(uint64_t time, Callback callback, uint64_t period) {
+    EventId id = nextId++;
+    events.push_back({time, period, id, std::move(callback)});
+    updateNext();
+    return id;
+}
+
+void Scheduler::cancel(EventId id) {
+    for (size_t i = 0; i < events.size(); i++) {
+        if (events[i].id == id) {
+            events.erase(events.begin() + i);
+            break;
+        }
+    }
+    updateNext();
+}
+
+void Scheduler::reschedule(EventId id, uint64_t time) {
+    for (Event& event : events)
+        if (event.id == id) event.time = time;
+    updateNext();
+}
+
+void Scheduler::runDue(uint64_t now) {
+    while (next <= now) {
+        // Earliest due event; ties go to the one scheduled first
+        size_t due = 0;
+        for (size_t i = 1; i < events.size(); i++)
+            if (events[i].time < events[due].time || (events[i].time == events[due].time && events[i].id < events[due].id))
+                due = i;
+
+        // Re-arm or retire it before calling out, so the callback may schedule or cancel freely
+        uint64_t time = events[due].time;
+        Callback callback = events[due].period ? events[due].callback : std::move(events[due].callback);
+        if (events[due].period)
+            events[due].time += events[due].period;
+        else
+            events.erase(events.begin() + due);
+        updateNext();
+
+        callback(time);
+    }
+}
+
+void Scheduler::updateNext() {
+    next = NEVER;
+    for (const Event& event : events)
+        if (event.time < next) next = event.time;
+}
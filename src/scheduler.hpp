@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Timed events on an absolute CPU cycle timeline.
+//
+// The owner runs the CPU up to nextEventTime(), adds the cycles actually
+// executed to its clock, and calls runDue(). Since execute() stops at the
+// first instruction boundary at or past its budget, an event fires on the
+// first boundary at or after its timestamp, and any overshoot only delays
+// that one event: periodic events are re-armed from their scheduled time,
+// never from the time they happened to fire, so nothing drifts.
+class Scheduler {
+public:
+    using Callback = std::function<void(uint64_t time)>;   // Called with the event's scheduled time
+    using EventId  = uint32_t;
+
+    static constexpr uint64_t NEVER = UINT64_MAX;
+
+    EventId  schedule(uint64_t time, Callback callback, uint64_t period = 0);  // period 0 = fire once
+    void     cancel(EventId id);
+    void     reschedule(EventId id, uint64_t time);        // Move an event, e.g. after restoring a snapshot
+    uint64_t nextEventTime() const                          { return next; }
+    void     runDue(uint64_t now);                          // Fire every event due at or before `now`, in time order
+
+private:
+    struct Event {
+        uint64_t time;
+        uint64_t period;
+        EventId  id;
+        Callback callback;
+    };
+
+    std::vector<Event> events;      // A handful at most, so kept unsorted
+    uint64_t next = NEVER;          // Earliest event time, cached for the run loop
+    EventId  nextId = 0;
+
+    void updateNext();
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Little-endian field encoding for the save state and movie file formats,
+// independent of the host's byte order and struct layout
+
+template <typename T>
+void putLE(std::vector<uint8_t>& out, T value) {
+    for (size_t i = 0; i < sizeof(T); i++)
+        out.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i)));
+}
+
+// Reads a field at `at` and moves past it; false if the data ends first
+template <typename T>
+bool getLE(const std::vector<uint8_t>& in, size_t& at, T& value) {
+    if (at + sizeof(T) > in.size()) return false;
+    uint64_t v = 0;
+    for (size_t i = 0; i < sizeof(T); i++)
+        v |= static_cast<uint64_t>(in[at++]) << (8 * i);
+    value = static_cast<T>(v);
+    return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-capacity lock-free ring buffer for exactly one producer thread and
+// one consumer thread. push() never blocks or allocates: when the ring is
+// full the item is dropped and counted in overflowCount().
+//
+// The producer's and consumer's indices live on separate cache lines, and
+// each side keeps a private copy of the other's index, only re-reading the
+// shared one when the copy says the ring is full (or empty). In the common
+// case a push or pop touches no cache line the other thread is writing.
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer side
+    bool push(const T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - cachedTail == Capacity) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h - cachedTail == Capacity) {
+                overflows.store(overflows.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        items[h & (Capacity - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (cachedHead == t) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (cachedHead == t) return false;
+        }
+        item = items[t & (Capacity - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Safe from any thread
+    bool     empty() const          { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+    uint64_t overflowCount() const  { return overflows.load(std::memory_order_relaxed); }
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    // Producer's line
+    alignas(64) std::atomic<size_t>   head{0};      // Next slot to write
+    size_t                            cachedTail = 0;
+    std::atomic<uint64_t>             overflows{0}; // Items dropped because the ring was full
+
+    // Consumer's line
+    alignas(64) std::atomic<size_t>   tail{0};      // Next slot to read
+    size_t                            cachedHead = 0;
+
+    alignas(64) std::array<T, Capacity> items{};
+};
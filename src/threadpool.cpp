@@ -0,0 +1,104 @@
+#include "threadpool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threadCount) : task(nullptr), count(), grain(), remaining(), generation(), stopping() {
+    threadCount = std::max(threadCount, 1u);
+    for (unsigned i = 0; i < threadCount; i++)
+        workers.push_back(std::make_unique<Worker>());
+
+    // Worker 0 is whichever thread calls parallelFor()
+    for (unsigned i = 1; i < threadCount; i++)
+        threads.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const Task& task) {
+    grain = std::max<size_t>(grain, 1);
+    size_t chunkCount = (count + grain - 1) / grain;
+    if (chunkCount == 0) return;
+
+    this->task = &task;
+    this->count = count;
+    this->grain = grain;
+    remaining.store(chunkCount, std::memory_order_relaxed);
+
+    // Deal each worker a contiguous run of chunks for locality
+    size_t workerCount = workers.size();
+    for (size_t w = 0; w < workerCount; w++) {
+        std::lock_guard<std::mutex> lock(workers[w]->mutex);
+        for (size_t c = chunkCount * w / workerCount; c < chunkCount * (w + 1) / workerCount; c++)
+            workers[w]->chunks.push_back(c);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        generation++;
+    }
+    wake.notify_all();
+
+    runChunks(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return remaining.load(std::memory_order_acquire) == 0; });
+}
+
+void ThreadPool::workerLoop(unsigned self) {
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        runChunks(self);
+    }
+}
+
+// Runs chunks until neither this worker's deque nor anyone else's has any left
+void ThreadPool::runChunks(unsigned self) {
+    size_t chunk;
+    while (pop(self, chunk) || steal(self, chunk)) {
+        size_t begin = chunk * grain;
+        (*task)(begin, std::min(begin + grain, count));
+
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.notify_all();
+        }
+    }
+}
+
+// The owner works from the back of its deque...
+bool ThreadPool::pop(unsigned self, size_t& chunk) {
+    Worker& worker = *workers[self];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.chunks.empty()) return false;
+    chunk = worker.chunks.back();
+    worker.chunks.pop_back();
+    return true;
+}
+
+// ...and thieves take from the front, the far end of the victim's run
+bool ThreadPool::steal(unsigned self, size_t& chunk) {
+    size_t workerCount = workers.size();
+    for (size_t i = 1; i < workerCount; i++) {
+        Worker& victim = *workers[(self + i) % workerCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.chunks.empty()) continue;
+        chunk = victim.chunks.front();
+        victim.chunks.pop_front();
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size work-stealing thread pool for fork/join loops.
+//
+// parallelFor() cuts [0, count) into chunks of `grain` items and deals each
+// worker a contiguous run of chunks in its own deque. A worker takes chunks
+// from the back of its deque and, once that is empty, steals from the front
+// of the others', so uneven chunks (e.g. one machine hitting an expensive
+// scene) are rebalanced instead of stalling the whole step. The calling
+// thread acts as worker 0, so a pool of one thread spawns nothing.
+class ThreadPool {
+public:
+    using Task = std::function<void(size_t begin, size_t end)>;
+
+    explicit ThreadPool(unsigned threadCount = std::thread::hardware_concurrency());
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void     parallelFor(size_t count, size_t grain, const Task& task); // Blocks until every chunk has run
+    unsigned threadCount() const                                        { return static_cast<unsigned>(workers.size()); }
+
+private:
+    // Padded so neighbouring workers' locks don't share a cache line
+    struct alignas(64) Worker {
+        std::mutex         mutex;
+        std::deque<size_t> chunks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread>             threads;
+
+    // The current loop. Written before its chunks are pushed, so a worker that
+    // pops a chunk (under the deque lock) always sees the matching fields.
+    const Task*         task;
+    size_t              count;
+    size_t              grain;
+    std::atomic<size_t> remaining;  // Chunks not yet finished
+
+    std::mutex              mutex;
+    std::condition_variable wake;   // Signals a new loop or shutdown to the workers
+    std::condition_variable done;   // Signals the caller that `remaining` reached zero
+    uint64_t                generation;
+    bool                    stopping;
+
+    void workerLoop(unsigned self);
+    void runChunks(unsigned self);
+    bool pop(unsigned self, size_t& chunk);
+    bool steal(unsigned self, size_t& chunk);
+};
@@ -0,0 +1,102 @@
+#include "trace.hpp"
+#include "cpu.hpp"
+
+#include <algorithm>
+
+RingTrace::RingTrace(size_t capacity) : mask(), head() {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    buffer.resize(size);
+    mask = size - 1;
+}
+
+size_t RingTrace::size() const {
+    return head < buffer.size() ? head : buffer.size();
+}
+
+const TraceRecord& RingTrace::operator[](size_t i) const {
+    return buffer[(head - size() + i) & mask];
+}
+
+void RingTrace::dump(FILE* out) const {
+    for (size_t i = 0; i < size(); i++) {
+        const TraceRecord& rec = (*this)[i];
+        Intel8080::disassemble(rec.opcode, rec.data, rec.pc, out);
+    }
+}
+
+TextFileTrace::TextFileTrace(const std::string& filePath) : fileBuffer(1 << 20) {
+    file = fopen(filePath.c_str(), "w");
+    if (!file) {
+        std::cerr << "Failed to open trace file: " << filePath << std::endl;
+        return;
+    }
+    setvbuf(file, fileBuffer.data(), _IOFBF, fileBuffer.size());
+}
+
+TextFileTrace::~TextFileTrace() {
+    if (file) fclose(file);
+}
+
+void TextFileTrace::record(const Intel8080&, const TraceRecord& rec) {
+    if (file) Intel8080::disassemble(rec.opcode, rec.data, rec.pc, file);
+}
+
+BinaryFileTrace::BinaryFileTrace(const std::string& filePath, size_t batchSize) : batch(batchSize), count() {
+    file = fopen(filePath.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to open trace file: " << filePath << std::endl;
+        return;
+    }
+    uint32_t header[2] = { TRACE_VERSION, sizeof(TraceRecord) };
+    fwrite(TRACE_MAGIC, sizeof(TRACE_MAGIC), 1, file);
+    fwrite(header, sizeof(header), 1, file);
+}
+
+BinaryFileTrace::~BinaryFileTrace() {
+    flush();
+    if (file) fclose(file);
+}
+
+void BinaryFileTrace::flush() {
+    if (file && count > 0)
+        fwrite(batch.data(), sizeof(TraceRecord), count, file);
+    count = 0;
+}
+
+TraceReader::TraceReader(const std::string& filePath, size_t batchSize) : batch(batchSize), count(), at(), consumed() {
+    file = fopen(filePath.c_str(), "rb");
+    if (!file) {
+        std::cerr << "Failed to open trace file: " << filePath << std::endl;
+        return;
+    }
+
+    char magic[sizeof(TRACE_MAGIC)];
+    uint32_t header[2];
+    if (fread(magic, sizeof(magic), 1, file) != 1 || !std::equal(magic, magic + sizeof(magic), TRACE_MAGIC) ||
+        fread(header, sizeof(header), 1, file) != 1) {
+        std::cerr << "Not a trace file: " << filePath << std::endl;
+    } else if (header[0] != TRACE_VERSION || header[1] != sizeof(TraceRecord)) {
+        std::cerr << "Unsupported trace version " << header[0] << ": " << filePath << std::endl;
+    } else {
+        return;
+    }
+    fclose(file);
+    file = nullptr;
+}
+
+TraceReader::~TraceReader() {
+    if (file) fclose(file);
+}
+
+bool TraceReader::next(TraceRecord& rec) {
+    if (at == count) {
+        if (!file) return false;
+        count = fread(batch.data(), sizeof(TraceRecord), batch.size(), file);
+        at = 0;
+        if (count == 0) return false;
+    }
+    rec = batch[at++];
+    consumed++;
+    return true;
+}
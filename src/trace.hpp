@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class Intel8080;
+
+// Snapshot of a single instruction as it is about to execute: the bytes
+// fetched, the whole register file and the cycle it starts on. A fixed 24
+// bytes without padding, so a ring buffer or binary file write is a plain copy.
+struct TraceRecord {
+    uint64_t cycle;     // Intel8080::cycleCount() before execution
+    uint16_t pc;        // Address of the opcode
+    uint16_t sp;        // Stack pointer before execution
+    uint8_t  opcode;    // Instruction byte
+    uint8_t  data[2];   // The two bytes following the opcode (immediate/address operands)
+    uint8_t  reg[8];    // B, C, D, E, H, L, A and FLAGS (fully evaluated) before execution
+    uint8_t  reserved;  // Padding, always 0
+};
+static_assert(sizeof(TraceRecord) == 24);
+
+// Binary trace files start with a 16-byte header:
+//   "I8080TRC", u32 version, u32 record size
+// followed by TraceRecords as laid out in memory (little-endian on every
+// platform the emulator builds for). See tools/tracetool.cpp for decoding,
+// filtering and diffing them.
+constexpr char     TRACE_MAGIC[8] = {'I', '8', '0', '8', '0', 'T', 'R', 'C'};
+constexpr uint32_t TRACE_VERSION  = 1;
+
+// Trace sinks are handed to Intel8080::execute as a template parameter.
+// Every sink exposes a compile-time `enabled` flag and a record() method;
+// when `enabled` is false the execute loop never builds a record, so the
+// "off" configuration compiles to the same loop as before tracing existed.
+
+// Tracing disabled.
+struct NullTrace {
+    static constexpr bool enabled = false;
+    void record(const Intel8080&, const TraceRecord&) {}
+};
+
+// Counts executed instructions without storing anything.
+struct CountTrace {
+    static constexpr bool enabled = true;
+    uint64_t count = 0;
+    void record(const Intel8080&, const TraceRecord&) { count++; }
+};
+
+// Keeps the most recent records in memory, overwriting the oldest ones.
+// Useful for post-mortem dumps when the CPU hits something unexpected.
+class RingTrace {
+public:
+    static constexpr bool enabled = true;
+
+    explicit RingTrace(size_t capacity = 1 << 16);  // Capacity is rounded up to a power of two
+
+    void   record(const Intel8080&, const TraceRecord& rec) { buffer[head++ & mask] = rec; }
+    size_t size() const;                                    // Number of valid records
+    const  TraceRecord& operator[](size_t i) const;         // 0 is the oldest valid record
+    void   dump(FILE* out) const;                           // Disassemble the buffer, oldest first
+    void   clear()                                          { head = 0; }
+
+private:
+    std::vector<TraceRecord> buffer;
+    size_t mask;
+    size_t head;
+};
+
+// Writes a disassembly listing to a file through a large stdio buffer.
+class TextFileTrace {
+public:
+    static constexpr bool enabled = true;
+
+    explicit TextFileTrace(const std::string& filePath);
+    ~TextFileTrace();
+    TextFileTrace(const TextFileTrace&) = delete;
+    TextFileTrace& operator=(const TextFileTrace&) = delete;
+
+    void record(const Intel8080& cpu, const TraceRecord& rec);
+    bool isOpen() const { return file != nullptr; }
+
+private:
+    FILE* file;
+    std::vector<char> fileBuffer;
+};
+
+// Writes a binary trace file, batching records in memory and flushing
+// with a single fwrite once the batch (1.5 MB by default) is full.
+class BinaryFileTrace {
+public:
+    static constexpr bool enabled = true;
+
+    explicit BinaryFileTrace(const std::string& filePath, size_t batchSize = 1 << 16);
+    ~BinaryFileTrace();
+    BinaryFileTrace(const BinaryFileTrace&) = delete;
+    BinaryFileTrace& operator=(const BinaryFileTrace&) = delete;
+
+    void record(const Intel8080&, const TraceRecord& rec) { write(rec); }
+    void write(const TraceRecord& rec) {
+        if (count == batch.size()) flush();
+        batch[count++] = rec;
+    }
+    void flush();
+    bool isOpen() const { return file != nullptr; }
+
+private:
+    FILE* file;
+    std::vector<TraceRecord> batch;
+    size_t count;
+};
+
+// Reads a binary trace file front to back, a batch of records at a time.
+class TraceReader {
+public:
+    explicit TraceReader(const std::string& filePath, size_t batchSize = 1 << 16);
+    ~TraceReader();
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+
+    bool     next(TraceRecord& rec);                        // False at the end of the trace
+    uint64_t index() const      { return consumed; }        // Records returned so far
+    bool     isOpen() const     { return file != nullptr; } // Opened, and has a matching header
+
+private:
+    FILE* file;
+    std::vector<TraceRecord> batch;
+    size_t count;
+    size_t at;
+    uint64_t consumed;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free triple buffer handing the latest value from one producer thread
+// to one consumer thread. The producer fills writeBuffer() and publishes it;
+// the consumer picks up the most recently published buffer with update().
+// The producer never waits: a slow consumer simply skips the values it was
+// too late for, and the buffer being read is never overwritten. A consumer
+// with nothing else to do can block in wait() until the next value arrives.
+template <typename T>
+class TripleBuffer {
+public:
+    // Producer side
+    T&   writeBuffer()                      { return buffers[back].value; }
+    void publish() {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+        middle.notify_one();
+    }
+
+    // Consumer side. Returns false if nothing new was published since the last call.
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    // Blocks until a value the consumer hasn't seen is published, then picks it up
+    void wait() {
+        uint8_t seen;
+        while (!((seen = middle.load(std::memory_order_relaxed)) & FRESH))
+            middle.wait(seen, std::memory_order_relaxed);
+        update();
+    }
+    const T& readBuffer() const             { return buffers[front].value; }
+
+private:
+    static constexpr uint8_t INDEX = 0x03;
+    static constexpr uint8_t FRESH = 0x04;  // Set in `middle` when it holds a buffer the consumer hasn't seen
+
+    struct alignas(64) Slot {
+        T value{};
+    };
+
+    std::array<Slot, 3> buffers;
+    alignas(64) std::atomic<uint8_t> middle{1};     // Buffer in flight between the two sides
+    alignas(64) uint8_t back = 0;                   // Owned by the producer
+    alignas(64) uint8_t front = 2;                  // Owned by the consumer
+};
@@ -2,22 +2,6 @@
 
 /* Utility functions for reading/writing memory/registers */
 
-// Reads an 8-bit value from a specified register (or memory location when r == M).
-uint8_t Intel8080::readReg8(uint8_t r) {
-    if (r == M)
-        return read(reg16_HL());
-    else
-        return reg8[r];
-}
-
-// Writes an 8-bit value to a specified register (or memory location when r == M).
-void Intel8080::writeReg8(uint8_t r, uint8_t value) {
-    if (r == M)
-        write(reg16_HL(), value);
-    else
-        reg8[r] = value;
-}
-
 // Reads a 16-bit value from a register pair.
 // Register pair 'RP' fields:
 // 00=BC   (B:C as 16 bit register)
@@ -124,47 +108,15 @@ void Intel8080::write16RP_PUSHPOP(uint8_t rp, uint16_t value) {
             // 0xD7 = 0b 1101 0111 (unused flag bits 3 and 5 are always 0)
             reg8[FLAGS] = ((value & 0xFF) | 0x02) & 0xD7;
             reg8[A]     =  value >> 8;
+            zspLazy     =  false;
         default:
             break;
     }
 }
 
 
-// Pushes a 16-bit value onto the stack (little endian)
-void Intel8080::push(uint16_t value) {
-    write(--sp, value >> 8);    // write MSB after LSB
-    write(--sp, value & 0xFF);  // write LSB before MSB
-}
-
-// Pops a 16-bit value from the stack
-uint16_t Intel8080::pop() {
-    temp16 = read(sp++);
-    temp16 |= ((uint16_t) read(sp++)) << 8;
-    return temp16;              // MSB | LSB
-}
-
 /* Utility functions for setting/getting/testing condition flags */
 
-// Sets or clears a specific flag.
-void Intel8080::SetFlag(FLAGS8080 f, bool v) {
-    if (v)
-        reg8[FLAGS] |= (1 << f);
-    else
-        reg8[FLAGS] &= ~(1 << f);
-}
-
-// Sets Zero, Sign, and Parity flags based on value.
-void Intel8080::SetZSP(uint8_t value) {
-    SetFlag(Z, value == 0);
-    SetFlag(S, value & 0x80);
-    SetFlag(P, parity(value));
-}
-
-// Retrieves the value of a specific flag.
-uint8_t Intel8080::GetFlag(FLAGS8080 f) {
-    return (reg8[FLAGS] >> f) & 1;
-}
-
 // Tests condition codes.
 //
 // Condition code 'CCC' fields: (FLAGS: S Z x A x P x C)
@@ -190,31 +142,3 @@ bool Intel8080::TestCond(uint8_t code) {
         default:        return false;
     }
 }
-
-// Tests parity of a given byte. Returns true if there is an even number of 1 bits.
-// See approach 2 in editorial: https://leetcode.com/problems/number-of-1-bits/editorial/
-bool Intel8080::parity(uint8_t value) {
-    uint8_t oneBitsCount;
-    for (oneBitsCount = 0; value != 0; oneBitsCount++)
-        value &= (value - 1);
-    return (oneBitsCount & 1) == 0;
-}
-
-// Checks if an addition operation resulted in a carry.
-//
-// Basically the flag is testing the result of upper bits:
-// Carry can occur in one of three cases:
-// 1. msb(a) and msb(b) are set (0.1xxx + 0.1xxx -> 1.0xxx)
-// 2. msb(a) is set but msb(result) is not set (0.1xxx + 0.xxxx -> 1.0xxx)
-// 3. msb(b) is set but msb(result) is not set (0.xxxx + 0.1xxx -> 1.0xxx)
-// Source: https://www.reddit.com/r/EmuDev/comments/110epqk/comment/j89y04a/?utm_source=share&utm_medium=web2x&context=3
-bool Intel8080::carry(uint8_t a, uint8_t b, uint8_t result, uint8_t mask) {
-    return ((a & b) | (a & ~result) | (b & ~result)) & mask;
-}
-
-// Checks if a subtraction operation resulted in a borrow.
-// a - b = result => a = b + result
-bool Intel8080::borrow(uint8_t a, uint8_t b, uint8_t result, uint8_t mask) {
-    return carry(result, b, a, mask);
-}
-
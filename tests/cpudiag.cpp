@@ -0,0 +1,107 @@
+#include "cpu.hpp"
+#include "jit.hpp"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+// Runs the Microcosm 8080/8085 CPU diagnostic (cpudiag.bin, a CP/M program
+// assembled at 0100h) on every execution engine and checks that it reports
+// "CPU IS OPERATIONAL".
+//
+// CP/M is reduced to the two entry points the program uses: the BDOS at
+// 0005h (C = 9 prints the '$'-terminated string at DE, C = 2 the character
+// in E) and the warm boot at 0000h, which it jumps to when done. Both hold a
+// HLT, so execute() returns there on every engine; the BDOS call is then
+// serviced from the saved registers and its RET done by hand. The program is
+// run repeatedly on the same CPU, so the JIT gets to translate its blocks.
+// The build recompiles cpudiag.bin into this program for the Aot engine.
+//
+// Usage: Intel_8080_cpudiag cpudiag.bin
+
+constexpr uint16_t WBOOT = 0x0000;
+constexpr uint16_t BDOS  = 0x0005;
+constexpr uint8_t  HLT   = 0x76;
+constexpr uint64_t CYCLE_LIMIT = 10000000;   // Per pass; the diagnostic needs a few thousand
+constexpr int      PASSES = Jit::HOT_THRESHOLD + 4;  // Enough for the JIT to translate its blocks and run them
+
+// CpuState::reg8 indices
+constexpr int REG_C = 1, REG_D = 2, REG_E = 3;
+
+struct Engine {
+    const char*          name;
+    Intel8080::Dispatch  dispatch;
+};
+
+constexpr Engine ENGINES[] = {
+    {"table",  Intel8080::Dispatch::Table},
+    {"switch", Intel8080::Dispatch::Switch},
+    {"block",  Intel8080::Dispatch::Block},
+    {"jit",    Intel8080::Dispatch::Jit},
+    {"aot",    Intel8080::Dispatch::Aot},
+};
+
+// Runs the diagnostic from 0100h to its warm boot and appends what it printed
+static bool runPass(Intel8080& cpu, std::string& output) {
+    CpuState state;
+    cpu.saveState(state);
+    state.reg8 = {};
+    state.sp = 0;
+    state.pc = 0x100;
+    cpu.loadState(state);
+
+    uint64_t limit = cpu.cycleCount() + CYCLE_LIMIT;
+    while (cpu.cycleCount() < limit) {
+        cpu.execute(10000);
+        cpu.saveState(state);
+        if (state.pc == WBOOT) return true;
+        if (state.pc != BDOS) continue;
+
+        uint8_t function = state.reg8[REG_C];
+        uint16_t addr = state.reg8[REG_D] << 8 | state.reg8[REG_E];
+        if (function == 9) {
+            for (uint8_t c; (c = cpu.read(addr)) != '$'; addr++)
+                output += static_cast<char>(c);
+        } else if (function == 2) {
+            output += static_cast<char>(state.reg8[REG_E]);
+        }
+        state.pc = cpu.memory->read16(state.sp);
+        state.sp += 2;
+        cpu.loadState(state);
+    }
+    fprintf(stderr, "cpudiag did not finish within %llu cycles\n", (unsigned long long) CYCLE_LIMIT);
+    return false;
+}
+
+// Runs the diagnostic PASSES times on one CPU; every pass has to succeed
+static bool run(const char* binPath, Intel8080::Dispatch dispatch, std::string& output) {
+    auto cpu = std::make_unique<Intel8080>();
+    if (!cpu->memory->load(binPath, 0x100)) return false;
+    cpu->write(WBOOT, HLT);
+    cpu->write(BDOS, HLT);
+    cpu->setDispatch(dispatch);
+
+    for (int pass = 0; pass < PASSES; pass++) {
+        output.clear();
+        if (!runPass(*cpu, output) || output.find("CPU IS OPERATIONAL") == std::string::npos) return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: Intel_8080_cpudiag cpudiag.bin\n");
+        return 2;
+    }
+
+    int failures = 0;
+    for (const Engine& engine : ENGINES) {
+        std::string output;
+        bool passed = run(argv[1], engine.dispatch, output);
+        for (char& c : output)
+            if (c == '\r' || c == '\n' || c == '\f') c = ' ';
+        printf("%-8s %s  %s\n", engine.name, passed ? "pass" : "FAIL", output.c_str());
+        failures += !passed;
+    }
+    return failures ? 1 : 0;
+}
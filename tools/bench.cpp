@@ -0,0 +1,243 @@
+#include "aot.hpp"
+#include "framebuffer.hpp"
+#include "jit.hpp"
+#include "machine.hpp"
+#include "rewind.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+// Measures raw instruction throughput of each execution engine by running the
+// Space Invaders ROM headless (no display, no audio, no frame throttling), and
+// on a synthetic loop of memory-heavy instructions. The aot row shows up
+// when the build recompiled a ROM (I8080_AOT_ROM); on any other ROM it is
+// the block interpreter. Engines are timed with idle skipping off, so every
+// counted instruction is executed; the idle row shows what skipping saves.
+//
+// Usage: Intel_8080_bench [rom] [frames]
+
+// Runs `frames` emulated frames on the given engine
+template <typename Trace>
+static bool runFrames(const char* romPath, int frames, Intel8080::Dispatch dispatch, bool idleSkip, Trace& trace) {
+    auto machine = std::make_unique<Machine>();
+    if (!machine->load(romPath)) return false;
+    machine->cpu.setDispatch(dispatch);
+    machine->cpu.setIdleSkip(idleSkip);
+
+    for (int i = 0; i < frames; i++)
+        machine->runFrame(trace);
+    return true;
+}
+
+static void bench(const char* name, const char* romPath, int frames, Intel8080::Dispatch dispatch) {
+    // All engines execute the same instruction stream, so count it once untimed
+    CountTrace counter;
+    if (!runFrames(romPath, frames, dispatch, false, counter)) exit(1);
+
+    NullTrace trace;
+    auto start = std::chrono::steady_clock::now();
+    runFrames(romPath, frames, dispatch, false, trace);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    double seconds = elapsed.count();
+    printf("%-8s %10llu instr  %8.3f s  %8.2f MIPS  %8.0f frames/s\n",
+           name, (unsigned long long) counter.count, seconds,
+           counter.count / seconds / 1e6, frames / seconds);
+}
+
+// Times the ROM run on the default engine with and without idle skipping
+static void benchIdleSkip(const char* romPath, int frames) {
+    double seconds[2];
+    uint64_t skipped = 0, total = 0;
+    for (int skip = 0; skip < 2; skip++) {
+        auto machine = std::make_unique<Machine>();
+        if (!machine->load(romPath)) exit(1);
+        machine->cpu.setIdleSkip(skip);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; i++)
+            machine->runFrame();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        seconds[skip] = elapsed.count();
+        skipped = machine->cpu.idleCycles();
+        total = machine->cpu.cycleCount();
+    }
+
+    printf("%-8s %8.3f s off  %8.3f s on  %6.2fx faster  %5.1f%% of cycles skipped\n", "idle",
+           seconds[0], seconds[1], seconds[0] / seconds[1], total ? 100.0 * skipped / total : 0.0);
+}
+
+// A loop of instructions that all touch memory, on a bare CPU with flat RAM:
+// MOV M and MOV r,M on a 256-byte buffer, PUSH, XTHL and POP on the stack,
+// SHLD/LHLD, and CALL/RET, plus the 16-bit operand fetches of LXI, JMP and CALL
+constexpr std::array<uint8_t, 28> MEMORY_LOOP = {
+    0x31, 0x00, 0x80,   //       LXI  SP,8000h
+    0x21, 0x00, 0x40,   //       LXI  H,4000h
+    0x77,               // loop: MOV  M,A
+    0x46,               //       MOV  B,M
+    0x2C,               //       INR  L          ; stays within 4000h-40FFh
+    0xC5,               //       PUSH B
+    0xD5,               //       PUSH D
+    0xE3,               //       XTHL
+    0xE3,               //       XTHL
+    0xD1,               //       POP  D
+    0xC1,               //       POP  B
+    0x22, 0x00, 0x50,   //       SHLD 5000h
+    0x2A, 0x00, 0x50,   //       LHLD 5000h
+    0xCD, 0x1B, 0x00,   //       CALL sub
+    0xC3, 0x06, 0x00,   //       JMP  loop
+    0xC9,               // sub:  RET
+};
+
+template <typename Trace>
+static void runMemoryLoop(uint64_t cycles, Intel8080::Dispatch dispatch, Trace& trace) {
+    auto cpu = std::make_unique<Intel8080>();
+    cpu->memory->load(MEMORY_LOOP.data(), MEMORY_LOOP.size(), 0);
+    cpu->setDispatch(dispatch);
+    cpu->setIdleSkip(false);
+    for (uint64_t done = 0; done < cycles; done += 100000)
+        cpu->execute(100000, trace);
+}
+
+static void benchMemoryOps(const char* name, uint64_t cycles, Intel8080::Dispatch dispatch) {
+    CountTrace counter;
+    runMemoryLoop(cycles, dispatch, counter);
+
+    NullTrace trace;
+    auto start = std::chrono::steady_clock::now();
+    runMemoryLoop(cycles, dispatch, trace);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    double seconds = elapsed.count();
+    printf("%-8s %10llu instr  %8.3f s  %8.2f MIPS  memory-heavy loop\n",
+           name, (unsigned long long) counter.count, seconds, counter.count / seconds / 1e6);
+}
+
+// Times the VRAM to RGBA conversion: once for whole screens, and once per
+// frame over a run converting only the strips written during that frame
+static void benchFramebuffer(const char* romPath, int frames) {
+    auto machine = std::make_unique<Machine>();
+    if (!machine->load(romPath)) exit(1);
+
+    std::vector<uint32_t> overlay(SCREEN_PIXELS, rgba(255, 255, 255));
+    std::vector<uint32_t> pixels(SCREEN_PIXELS);
+    std::array<uint32_t, SCREEN_STRIPS> stripVersions{};
+    std::chrono::duration<double, std::micro> incremental{};
+    uint64_t dirtyStrips = 0;
+    for (int i = 0; i < frames; i++) {
+        machine->runFrame();
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint16_t strip = 0; strip < SCREEN_STRIPS; strip++) {
+            uint32_t version = machine->cpu.memory->pageVersion((VRAM_START >> 8) + strip);
+            if (version == stripVersions[strip]) continue;
+            stripVersions[strip] = version;
+            convertStrip(machine->videoRam(), overlay.data(), pixels.data(), strip);
+            dirtyStrips++;
+        }
+        incremental += std::chrono::steady_clock::now() - start;
+    }
+
+    constexpr int iterations = 10000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        convertFramebuffer(machine->videoRam(), overlay.data(), pixels.data());
+    std::chrono::duration<double, std::micro> full = std::chrono::steady_clock::now() - start;
+
+    printf("%-8s %8.2f us/frame full  %8.2f us/frame dirty only  %5.1f of %d strips dirty\n", "display",
+           full.count() / iterations, incremental.count() / frames, (double) dirtyStrips / frames, SCREEN_STRIPS);
+}
+
+// Times in-memory save and restore, and checks that a restored machine
+// replays the same frames as the original
+static void benchSnapshot(const char* romPath, int frames) {
+    auto machine = std::make_unique<Machine>();
+    if (!machine->load(romPath)) exit(1);
+    for (int i = 0; i < frames / 2; i++)
+        machine->runFrame();
+
+    constexpr int iterations = 100000;
+    auto snapshot = std::make_unique<Snapshot>();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        machine->save(*snapshot);
+    std::chrono::duration<double, std::micro> save = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        machine->restore(*snapshot);
+    std::chrono::duration<double, std::micro> restore = std::chrono::steady_clock::now() - start;
+
+    for (int i = 0; i < frames / 2; i++)
+        machine->runFrame();
+    uint64_t expected = machine->ramHash();
+    machine->restore(*snapshot);
+    for (int i = 0; i < frames / 2; i++)
+        machine->runFrame();
+
+    printf("%-8s %8.3f us save  %8.3f us restore  %zu bytes  replay %s\n", "snapshot",
+           save.count() / iterations, restore.count() / iterations, sizeof(Snapshot),
+           machine->ramHash() == expected ? "matches" : "DIFFERS");
+}
+
+// Records every frame of a run in a RewindBuffer, then steps all the way
+// back checking each restored frame against the RAM hash it had
+static void benchRewind(const char* romPath, int frames) {
+    auto machine = std::make_unique<Machine>();
+    if (!machine->load(romPath)) exit(1);
+
+    RewindBuffer rewind(frames);
+    auto snapshot = std::make_unique<Snapshot>();
+    std::vector<uint64_t> hashes;
+    std::chrono::duration<double, std::micro> record{};
+    for (int i = 0; i < frames; i++) {
+        machine->runFrame();
+        hashes.push_back(machine->ramHash());
+        auto start = std::chrono::steady_clock::now();
+        machine->save(*snapshot);
+        rewind.push(*snapshot);
+        record += std::chrono::steady_clock::now() - start;
+    }
+    size_t bytes = rewind.bytes();
+
+    int mismatches = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = frames - 2; rewind.stepBack(*snapshot); i--) {
+        machine->restore(*snapshot);
+        mismatches += machine->ramHash() != hashes[i];
+    }
+    std::chrono::duration<double, std::micro> back = std::chrono::steady_clock::now() - start;
+
+    printf("%-8s %8.3f us record  %8.3f us step back  %8.0f bytes/frame  %s\n", "rewind",
+           record.count() / frames, back.count() / (frames - 1), (double) bytes / frames,
+           mismatches ? "MISMATCH" : "all frames match");
+}
+
+int main(int argc, char* argv[]) {
+    const char* romPath = argc > 1 ? argv[1] : "invaders";
+    int frames = argc > 2 ? atoi(argv[2]) : 6000;
+
+    bench("table",  romPath, frames, Intel8080::Dispatch::Table);
+    bench("switch", romPath, frames, Intel8080::Dispatch::Switch);
+    bench("block",  romPath, frames, Intel8080::Dispatch::Block);
+    if (Jit::available())
+        bench("jit",    romPath, frames, Intel8080::Dispatch::Jit);
+    if (Aot::available())
+        bench("aot",    romPath, frames, Intel8080::Dispatch::Aot);
+
+    // About as many cycles as the ROM run, 2 MHz for `frames` 60 Hz frames
+    uint64_t cycles = frames * 2000000ull / 60;
+    benchMemoryOps("table",  cycles, Intel8080::Dispatch::Table);
+    benchMemoryOps("switch", cycles, Intel8080::Dispatch::Switch);
+    benchMemoryOps("block",  cycles, Intel8080::Dispatch::Block);
+    if (Jit::available())
+        benchMemoryOps("jit",    cycles, Intel8080::Dispatch::Jit);
+    benchIdleSkip(romPath, frames);
+    benchFramebuffer(romPath, frames);
+    benchSnapshot(romPath, frames);
+    benchRewind(romPath, frames);
+    return 0;
+}
@@ -0,0 +1,415 @@
+#include "aot.hpp"
+#include "cpu.hpp"
+#include "instruction.hpp"
+#include "memory.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Static disassembly of a ROM image by recursive descent: starting from the
+// reset vector and the interrupt entry points, follows every JMP, CALL,
+// Jccc, Cccc and RST target to tell code from data, then writes a labelled
+// listing and the control-flow graph of the basic blocks found, or C++
+// code for the blocks that the build compiles into Dispatch::Aot (see
+// src/aot.hpp).
+//
+// Usage: Intel_8080_romcfg ROM [options]
+//   --base ADDR        Load the image at ADDR (hex) rather than 0000
+//   --entry ADDR       Also start from ADDR (hex); repeatable
+//   --listing PATH     Labelled listing, '-' for stdout (the default without other outputs)
+//   --dot PATH         Control-flow graph for Graphviz
+//   --json PATH        Blocks, edges and routines as JSON
+//   --cpp PATH         The blocks recompiled to C++, registered as an AotProgram
+//   --name NAME        Program name in the C++ source (default: the ROM's file name)
+//
+// The default entry points are 0000 (reset), 0008 (RST 1, mid-screen) and
+// 0010 (RST 2, VBLANK), the ones the Space Invaders hardware uses. Code
+// reached only through PCHL (jump tables) is not found and lists as data.
+
+enum ByteKind : uint8_t { DATA, OPCODE, OPERAND };
+
+enum LabelFlags : uint8_t {
+    ENTRY       = 1 << 0,   // Reset or interrupt vector, or --entry
+    CALLED      = 1 << 1,   // Target of CALL, Cccc or RST
+    JUMPED      = 1 << 2,   // Target of JMP or Jccc
+    LEADER      = 1 << 3,   // Starts a basic block
+};
+
+struct BasicBlock {
+    uint16_t start;
+    uint16_t end;                       // Address of the last instruction
+    uint32_t instructions;
+    uint32_t cycles;                    // Sum of the instructions' (taken) cycle costs
+    std::vector<uint16_t> successors;   // Blocks control can continue in, calls excluded
+    std::vector<uint16_t> calls;        // Routines called from the block
+};
+
+struct Routine {
+    uint16_t entry;
+    std::vector<uint16_t> blocks;       // Reachable from the entry without following calls
+    uint32_t bytes;
+};
+
+struct Analysis {
+    uint32_t                start;      // The ROM occupies [start, end)
+    uint32_t                end;
+    std::vector<uint8_t>    kind;       // ByteKind per address
+    std::vector<uint8_t>    labels;     // LabelFlags per address
+    std::vector<BasicBlock> blocks;     // In address order
+    std::vector<Routine>    routines;   // Entry points and call targets, in address order
+    uint32_t                overlaps = 0;   // Jumps into the middle of a decoded instruction
+
+    bool inRom(uint32_t addr) const { return addr >= start && addr < end; }
+};
+
+static std::string label(const Analysis& analysis, uint16_t addr) {
+    char text[16];
+    uint8_t flags = analysis.labels[addr];
+    if (flags & ENTRY && addr % 8 == 0 && addr < 0x40)
+        snprintf(text, sizeof(text), "rst%d", addr / 8);
+    else if (flags & ENTRY)
+        snprintf(text, sizeof(text), "entry_%04x", addr);
+    else if (flags & CALLED)
+        snprintf(text, sizeof(text), "sub_%04x", addr);
+    else
+        snprintf(text, sizeof(text), "loc_%04x", addr);
+    return text;
+}
+
+// Follows every path from the entry points, marking the bytes of each
+// instruction reached and labelling branch targets
+static void trace(const Memory& memory, const std::vector<uint16_t>& entries, Analysis& analysis) {
+    std::vector<uint16_t> pending(entries.rbegin(), entries.rend());
+    for (uint16_t entry : entries)
+        if (analysis.inRom(entry)) analysis.labels[entry] |= ENTRY | LEADER;
+
+    while (!pending.empty()) {
+        uint32_t pc = pending.back();
+        pending.pop_back();
+
+        while (analysis.inRom(pc) && analysis.kind[pc] != OPCODE) {
+            if (analysis.kind[pc] == OPERAND) {
+                analysis.overlaps++;
+                break;
+            }
+            Instruction instruction = decode(memory, static_cast<uint16_t>(pc));
+            if (instruction.flags & OpcodeInfo::UNDOCUMENTED || pc + instruction.length > analysis.end) break;
+            bool overlaps = false;
+            for (uint32_t i = 1; i < instruction.length; i++)
+                overlaps |= analysis.kind[pc + i] != DATA;
+            if (overlaps) {
+                analysis.overlaps++;
+                break;
+            }
+
+            analysis.kind[pc] = OPCODE;
+            for (uint32_t i = 1; i < instruction.length; i++)
+                analysis.kind[pc + i] = OPERAND;
+
+            if (instruction.hasTarget && analysis.inRom(instruction.target)) {
+                analysis.labels[instruction.target] |= (instruction.flags & OpcodeInfo::CALL ? CALLED : JUMPED) | LEADER;
+                pending.push_back(instruction.target);
+            }
+
+            pc += instruction.length;
+            bool stops = instruction.flags & (OpcodeInfo::JUMP | OpcodeInfo::RETURN | OpcodeInfo::HALTS) &&
+                         !(instruction.flags & OpcodeInfo::CONDITIONAL);
+            if (stops) break;
+            if (instruction.endsBlock() && analysis.inRom(pc)) analysis.labels[pc] |= LEADER;
+        }
+    }
+}
+
+// Splits the code into basic blocks and links them
+static void buildBlocks(const Memory& memory, Analysis& analysis) {
+    std::vector<int32_t> blockAt(RAM_SIZE, -1);
+    for (uint32_t pc = analysis.start; pc < analysis.end;) {
+        if (analysis.kind[pc] != OPCODE) {
+            pc++;
+            continue;
+        }
+
+        BasicBlock block{static_cast<uint16_t>(pc), static_cast<uint16_t>(pc), 0, 0, {}, {}};
+        Instruction last{};
+        do {
+            last = decode(memory, static_cast<uint16_t>(pc));
+            block.end = static_cast<uint16_t>(pc);
+            block.instructions++;
+            block.cycles += last.cycles;
+            pc += last.length;
+        } while (!last.endsBlock() && analysis.inRom(pc) && analysis.kind[pc] == OPCODE && !(analysis.labels[pc] & LEADER));
+
+        if (last.hasTarget && analysis.inRom(last.target) && analysis.kind[last.target] == OPCODE) {
+            if (last.flags & OpcodeInfo::CALL) block.calls.push_back(last.target);
+            else block.successors.push_back(last.target);
+        }
+        bool fallsThrough = !(last.flags & (OpcodeInfo::JUMP | OpcodeInfo::RETURN | OpcodeInfo::HALTS | OpcodeInfo::UNDOCUMENTED)) ||
+                            (last.flags & OpcodeInfo::CONDITIONAL);
+        if (fallsThrough && analysis.inRom(pc) && analysis.kind[pc] == OPCODE)
+            block.successors.push_back(static_cast<uint16_t>(pc));
+
+        blockAt[block.start] = static_cast<int32_t>(analysis.blocks.size());
+        analysis.blocks.push_back(std::move(block));
+    }
+
+    // A routine is everything reachable from its entry without following calls
+    std::vector<uint32_t> seen(analysis.blocks.size(), UINT32_MAX);
+    for (uint32_t addr = analysis.start; addr < analysis.end; addr++) {
+        if (!(analysis.labels[addr] & (ENTRY | CALLED)) || blockAt[addr] < 0) continue;
+        Routine routine{static_cast<uint16_t>(addr), {}, 0};
+        uint32_t id = static_cast<uint32_t>(analysis.routines.size());
+        std::vector<int32_t> stack{blockAt[addr]};
+        while (!stack.empty()) {
+            int32_t b = stack.back();
+            stack.pop_back();
+            if (b < 0 || seen[b] == id) continue;
+            seen[b] = id;
+            const BasicBlock& block = analysis.blocks[b];
+            routine.blocks.push_back(block.start);
+            routine.bytes += block.end + OPCODES[memory.read(block.end)].length - block.start;
+            for (uint16_t next : block.successors)
+                stack.push_back(blockAt[next]);
+        }
+        std::sort(routine.blocks.begin(), routine.blocks.end());
+        analysis.routines.push_back(std::move(routine));
+    }
+}
+
+static FILE* openOutput(const std::string& path) {
+    if (path == "-") return stdout;
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) fprintf(stderr, "Failed to open output file: %s\n", path.c_str());
+    return file;
+}
+
+static void closeOutput(FILE* file) {
+    if (file && file != stdout) fclose(file);
+}
+
+static void writeListing(FILE* out, const Memory& memory, const Analysis& analysis) {
+    for (uint32_t pc = analysis.start; pc < analysis.end;) {
+        if (analysis.kind[pc] == OPCODE) {
+            if (analysis.labels[pc] & (ENTRY | CALLED | JUMPED))
+                fprintf(out, "\n%s:\n", label(analysis, static_cast<uint16_t>(pc)).c_str());
+            Instruction instruction = decode(memory, static_cast<uint16_t>(pc));
+            char text[32], bytes[12] = {};
+            format(instruction, text, sizeof(text));
+            for (uint32_t i = 0; i < instruction.length; i++)
+                snprintf(bytes + i * 3, sizeof(bytes) - i * 3, "%02x ", memory.read(static_cast<uint16_t>(pc + i)));
+            if (instruction.hasTarget && analysis.inRom(instruction.target) && analysis.kind[instruction.target] == OPCODE)
+                fprintf(out, "%04x  %-9s  %-16s ; %s\n", pc, bytes, text, label(analysis, instruction.target).c_str());
+            else
+                fprintf(out, "%04x  %-9s  %s\n", pc, bytes, text);
+            pc += instruction.length;
+            continue;
+        }
+
+        // A run of data, eight bytes per line
+        fprintf(out, "%04x  DB   ", pc);
+        uint32_t n = 0;
+        for (; pc < analysis.end && analysis.kind[pc] != OPCODE && n < 8; pc++, n++)
+            fprintf(out, n ? ",$%02x" : "$%02x", memory.read(static_cast<uint16_t>(pc)));
+        fprintf(out, "\n");
+    }
+}
+
+static void writeDot(FILE* out, const Analysis& analysis) {
+    fprintf(out, "digraph rom {\n");
+    fprintf(out, "    node [shape=box, fontname=\"monospace\"];\n");
+    for (const BasicBlock& block : analysis.blocks) {
+        bool labelled = analysis.labels[block.start] & (ENTRY | CALLED | JUMPED);
+        std::string title = labelled ? label(analysis, block.start) + "\\n" : "";
+        fprintf(out, "    b%04x [label=\"%s%04x-%04x\\n%u instr, %u cycles\"%s];\n", block.start, title.c_str(),
+                block.start, block.end, block.instructions, block.cycles,
+                analysis.labels[block.start] & (ENTRY | CALLED) ? ", style=bold" : "");
+    }
+    for (const BasicBlock& block : analysis.blocks) {
+        for (uint16_t next : block.successors)
+            fprintf(out, "    b%04x -> b%04x;\n", block.start, next);
+        for (uint16_t callee : block.calls)
+            fprintf(out, "    b%04x -> b%04x [style=dashed, color=blue];\n", block.start, callee);
+    }
+    fprintf(out, "}\n");
+}
+
+static void writeAddresses(FILE* out, const std::vector<uint16_t>& addresses) {
+    fprintf(out, "[");
+    for (size_t i = 0; i < addresses.size(); i++)
+        fprintf(out, i ? ", %u" : "%u", addresses[i]);
+    fprintf(out, "]");
+}
+
+static void writeJson(FILE* out, const Analysis& analysis) {
+    uint32_t codeBytes = static_cast<uint32_t>(std::count_if(analysis.kind.begin(), analysis.kind.end(),
+                                                             [](uint8_t kind) { return kind != DATA; }));
+    fprintf(out, "{\n  \"start\": %u,\n  \"end\": %u,\n  \"codeBytes\": %u,\n  \"blocks\": [\n",
+            analysis.start, analysis.end, codeBytes);
+    for (size_t i = 0; i < analysis.blocks.size(); i++) {
+        const BasicBlock& block = analysis.blocks[i];
+        fprintf(out, "    {\"start\": %u, \"end\": %u, \"instructions\": %u, \"cycles\": %u, \"successors\": ",
+                block.start, block.end, block.instructions, block.cycles);
+        writeAddresses(out, block.successors);
+        fprintf(out, ", \"calls\": ");
+        writeAddresses(out, block.calls);
+        fprintf(out, "}%s\n", i + 1 < analysis.blocks.size() ? "," : "");
+    }
+    fprintf(out, "  ],\n  \"routines\": [\n");
+    for (size_t i = 0; i < analysis.routines.size(); i++) {
+        const Routine& routine = analysis.routines[i];
+        fprintf(out, "    {\"name\": \"%s\", \"entry\": %u, \"bytes\": %u, \"blocks\": ",
+                label(analysis, routine.entry).c_str(), routine.entry, routine.bytes);
+        writeAddresses(out, routine.blocks);
+        fprintf(out, "}%s\n", i + 1 < analysis.routines.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+// One function per basic block running each instruction inline with its
+// operand as a constant where Intel8080::inlinable allows, through its opcode
+// thunk otherwise, then the tables Aot needs to find the blocks and validate
+// the ROM
+static void writeCpp(FILE* out, const Memory& memory, const Analysis& analysis, const std::string& name) {
+    uint32_t codeBytes = static_cast<uint32_t>(std::count_if(analysis.kind.begin(), analysis.kind.end(),
+                                                             [](uint8_t kind) { return kind != DATA; }));
+    fprintf(out, "// Generated by Intel_8080_romcfg from %s: %zu blocks, %u bytes of code. Do not edit.\n",
+            name.c_str(), analysis.blocks.size(), codeBytes);
+    fprintf(out, "#include \"aot.hpp\"\n#include \"cpu.hpp\"\n#include \"opinline.hpp\"\n\nnamespace {\n\nusing I = Intel8080;\n");
+
+    std::vector<std::pair<uint8_t, uint8_t>> pages;     // First and last page of each block
+    for (const BasicBlock& block : analysis.blocks) {
+        std::vector<Instruction> instructions;
+        bool stores = false;
+        for (uint32_t pc = block.start; pc <= block.end; pc += instructions.back().length) {
+            instructions.push_back(decode(memory, static_cast<uint16_t>(pc)));
+            stores |= instructions.back().flags & OpcodeInfo::WRITES_MEMORY && pc < block.end;
+        }
+        uint8_t firstPage = block.start / PAGE_SIZE;
+        uint8_t lastPage = (block.end + instructions.back().length - 1) / PAGE_SIZE;
+        pages.emplace_back(firstPage, lastPage);
+
+        bool labelled = analysis.labels[block.start] & (ENTRY | CALLED | JUMPED);
+        fprintf(out, "\n// %04x-%04x%s%s\n", block.start, block.end, labelled ? " " : "",
+                labelled ? label(analysis, block.start).c_str() : "");
+        fprintf(out, "void b%04x(Intel8080* cpu, Aot&%s) {\n", block.start, stores ? " aot" : "");
+        for (const Instruction& instruction : instructions) {
+            char text[32], call[64], statement[128];
+            format(instruction, text, sizeof(text));
+            if (Intel8080::inlinable(instruction.opcode))
+                snprintf(call, sizeof(call), "I::opInline<0x%02x>(cpu, 0x%04x, 0x%0*x)", instruction.opcode,
+                         (instruction.pc + instruction.length) & 0xFFFF, instruction.length == 3 ? 4 : 2, instruction.imm);
+            else
+                snprintf(call, sizeof(call), "I::opThunk<0x%02x>(cpu, 0x%04x)", instruction.opcode, instruction.pc + 1);
+            if (instruction.pc == block.end)
+                snprintf(statement, sizeof(statement), "%s;", call);
+            else if (instruction.flags & OpcodeInfo::WRITES_MEMORY)
+                snprintf(statement, sizeof(statement), "if (%s <= 0 || !aot.current(0x%02x, 0x%02x, *cpu->memory)) return;",
+                         call, firstPage, lastPage);
+            else
+                snprintf(statement, sizeof(statement), "if (%s <= 0) return;", call);
+            fprintf(out, "    %-48s  // %s\n", statement, text);
+        }
+        fprintf(out, "}\n");
+    }
+
+    fprintf(out, "\nconst AotBlock BLOCKS[] = {\n");
+    for (size_t i = 0; i < analysis.blocks.size(); i++)
+        fprintf(out, "    {0x%04x, 0x%02x, 0x%02x, b%04x},\n", analysis.blocks[i].start, pages[i].first, pages[i].second,
+                analysis.blocks[i].start);
+    fprintf(out, "};\n\nconst uint64_t PAGE_HASHES[] = {\n");
+    for (uint32_t page = analysis.start / PAGE_SIZE; page <= (analysis.end - 1) / PAGE_SIZE; page++)
+        fprintf(out, "    0x%016llxull,\n", (unsigned long long) Aot::pageHash(memory, static_cast<uint8_t>(page),
+                                                                             analysis.start, analysis.end - analysis.start));
+    fprintf(out, "};\n\nconst AotProgram PROGRAM = {\"%s\", 0x%04x, %u, PAGE_HASHES, BLOCKS, sizeof(BLOCKS) / sizeof(BLOCKS[0])};\n",
+            name.c_str(), analysis.start, analysis.end - analysis.start);
+    fprintf(out, "const bool registered = Aot::add(PROGRAM);\n\n}\n");
+}
+
+static void usage() {
+    fprintf(stderr, "Usage: Intel_8080_romcfg ROM [--base ADDR] [--entry ADDR]... [--listing PATH] [--dot PATH] [--json PATH] "
+                    "[--cpp PATH [--name NAME]]\n");
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+    std::string romPath = argv[1];
+    std::vector<uint16_t> entries = {0x0000, 0x0008, 0x0010};
+    std::string listingPath, dotPath, jsonPath, cppPath;
+    std::string name = romPath.substr(romPath.find_last_of("/\\") + 1);
+    uint32_t base = 0;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if      (arg == "--entry" && hasValue)   entries.push_back(static_cast<uint16_t>(strtoul(argv[++i], nullptr, 16)));
+        else if (arg == "--base" && hasValue)    base = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 16));
+        else if (arg == "--listing" && hasValue) listingPath = argv[++i];
+        else if (arg == "--dot" && hasValue)     dotPath = argv[++i];
+        else if (arg == "--json" && hasValue)    jsonPath = argv[++i];
+        else if (arg == "--cpp" && hasValue)     cppPath = argv[++i];
+        else if (arg == "--name" && hasValue)    name = argv[++i];
+        else {
+            usage();
+            return 1;
+        }
+    }
+    if (listingPath.empty() && dotPath.empty() && jsonPath.empty() && cppPath.empty()) listingPath = "-";
+
+    std::vector<uint8_t> image;
+    if (!readFile(romPath, image)) return 1;
+    if (image.empty() || base + image.size() > RAM_SIZE) {
+        fprintf(stderr, "%s: %zu bytes do not fit at %04x\n", romPath.c_str(), image.size(), base);
+        return 1;
+    }
+    auto memory = std::make_unique<Memory>();
+    memory->load(image.data(), image.size(), static_cast<uint16_t>(base));
+
+    auto start = std::chrono::steady_clock::now();
+    Analysis analysis;
+    analysis.start = base;
+    analysis.end = base + static_cast<uint32_t>(image.size());
+    analysis.kind.assign(RAM_SIZE, DATA);
+    analysis.labels.assign(RAM_SIZE, 0);
+    trace(*memory, entries, analysis);
+    buildBlocks(*memory, analysis);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    uint32_t codeBytes = static_cast<uint32_t>(std::count_if(analysis.kind.begin(), analysis.kind.end(),
+                                                             [](uint8_t kind) { return kind != DATA; }));
+    fprintf(stderr, "%s: %u of %zu bytes code, %zu blocks, %zu routines, %u overlapping jumps, %.2f ms\n",
+            romPath.c_str(), codeBytes, image.size(), analysis.blocks.size(), analysis.routines.size(),
+            analysis.overlaps, elapsed.count());
+
+    bool ok = true;
+    if (!listingPath.empty()) {
+        FILE* out = openOutput(listingPath);
+        if (out) writeListing(out, *memory, analysis);
+        ok &= out != nullptr;
+        closeOutput(out);
+    }
+    if (!dotPath.empty()) {
+        FILE* out = openOutput(dotPath);
+        if (out) writeDot(out, analysis);
+        ok &= out != nullptr;
+        closeOutput(out);
+    }
+    if (!jsonPath.empty()) {
+        FILE* out = openOutput(jsonPath);
+        if (out) writeJson(out, analysis);
+        ok &= out != nullptr;
+        closeOutput(out);
+    }
+    if (!cppPath.empty()) {
+        FILE* out = openOutput(cppPath);
+        if (out) writeCpp(out, *memory, analysis, name);
+        ok &= out != nullptr;
+        closeOutput(out);
+    }
+    return ok ? 0 : 1;
+}
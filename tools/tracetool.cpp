@@ -0,0 +1,179 @@
+#include "instruction.hpp"
+#include "trace.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+
+// Offline analysis of binary traces written by BinaryFileTrace (see the
+// headless runner's --trace option).
+//
+// Usage: Intel_8080_tracetool <command> [options]
+//   dump TRACE [--pc START-END] [--limit N]        Decode records to text
+//   filter TRACE OUT --pc START-END                Keep the records whose PC is in range
+//   diff TRACE1 TRACE2 [--pc START-END] [--context N]
+//                                                  Report the first record that differs
+//
+// PC ranges are inclusive hex addresses, e.g. --pc 1a00-1aff. diff exits
+// with 1 when the traces differ, so it can gate scripts comparing engines.
+
+struct PcRange {
+    uint16_t start = 0x0000;
+    uint16_t end   = 0xFFFF;
+    bool contains(uint16_t pc) const { return pc >= start && pc <= end; }
+};
+
+static void usage() {
+    fprintf(stderr, "Usage: Intel_8080_tracetool dump TRACE [--pc START-END] [--limit N]\n"
+                    "       Intel_8080_tracetool filter TRACE OUT --pc START-END\n"
+                    "       Intel_8080_tracetool diff TRACE1 TRACE2 [--pc START-END] [--context N]\n");
+}
+
+static bool parseRange(const char* text, PcRange& range) {
+    char* end;
+    unsigned long start = strtoul(text, &end, 16);
+    if (*end != '-') return false;
+    unsigned long last = strtoul(end + 1, &end, 16);
+    if (*end != '\0' || start > last || last > 0xFFFF) return false;
+    range.start = static_cast<uint16_t>(start);
+    range.end = static_cast<uint16_t>(last);
+    return true;
+}
+
+static bool nextInRange(TraceReader& reader, const PcRange& range, TraceRecord& rec) {
+    while (reader.next(rec))
+        if (range.contains(rec.pc)) return true;
+    return false;
+}
+
+// One line per record: cycle, registers before execution, then the instruction
+static void printRecord(const char* prefix, const TraceRecord& rec) {
+    char text[32];
+    format(decode(rec.pc, rec.opcode, rec.data), text, sizeof(text));
+    printf("%s%12llu  A=%02x F=%02x BC=%02x%02x DE=%02x%02x HL=%02x%02x SP=%04x  %04x  %s\n", prefix,
+           (unsigned long long) rec.cycle, rec.reg[6], rec.reg[7], rec.reg[0], rec.reg[1],
+           rec.reg[2], rec.reg[3], rec.reg[4], rec.reg[5], rec.sp, rec.pc, text);
+}
+
+static int dump(const char* tracePath, const PcRange& range, uint64_t limit) {
+    TraceReader reader(tracePath);
+    if (!reader.isOpen()) return 1;
+
+    TraceRecord rec;
+    for (uint64_t n = 0; n < limit && nextInRange(reader, range, rec); n++)
+        printRecord("", rec);
+    return 0;
+}
+
+static int filter(const char* tracePath, const char* outPath, const PcRange& range) {
+    TraceReader reader(tracePath);
+    if (!reader.isOpen()) return 1;
+    BinaryFileTrace out(outPath);
+    if (!out.isOpen()) return 1;
+
+    TraceRecord rec;
+    uint64_t kept = 0;
+    while (nextInRange(reader, range, rec)) {
+        out.write(rec);
+        kept++;
+    }
+    printf("kept %llu of %llu records\n", (unsigned long long) kept, (unsigned long long) reader.index());
+    return 0;
+}
+
+// Names the fields two records disagree on
+static std::string differences(const TraceRecord& a, const TraceRecord& b) {
+    static const char* const REGISTER_NAMES[8] = {"B", "C", "D", "E", "H", "L", "A", "flags"};
+    std::string names;
+    auto add = [&](bool differs, const char* name) { if (differs) names += names.empty() ? name : std::string(" ") + name; };
+    add(a.pc != b.pc, "pc");
+    add(a.opcode != b.opcode || a.data[0] != b.data[0] || a.data[1] != b.data[1], "instruction");
+    for (int r = 0; r < 8; r++)
+        add(a.reg[r] != b.reg[r], REGISTER_NAMES[r]);
+    add(a.sp != b.sp, "SP");
+    add(a.cycle != b.cycle, "cycle");
+    return names;
+}
+
+static int diff(const char* firstPath, const char* secondPath, const PcRange& range, size_t context) {
+    TraceReader first(firstPath);
+    TraceReader second(secondPath);
+    if (!first.isOpen() || !second.isOpen()) return 1;
+
+    std::deque<TraceRecord> recent;     // The last records both traces agree on
+    TraceRecord a, b;
+    for (;;) {
+        bool hasA = nextInRange(first, range, a);
+        bool hasB = nextInRange(second, range, b);
+        if (!hasA && !hasB) {
+            printf("traces match: %llu records\n", (unsigned long long) first.index());
+            return 0;
+        }
+
+        if (hasA && hasB && memcmp(&a, &b, sizeof(TraceRecord)) == 0) {
+            recent.push_back(a);
+            if (recent.size() > context) recent.pop_front();
+            continue;
+        }
+
+        if (!hasA || !hasB) {
+            printf("%s ends after %llu records, %s goes on with\n", hasA ? secondPath : firstPath,
+                   (unsigned long long) (hasA ? second.index() : first.index()), hasA ? firstPath : secondPath);
+        } else {
+            printf("first difference at record %llu of %s, %llu of %s: %s\n",
+                   (unsigned long long) first.index() - 1, firstPath,
+                   (unsigned long long) second.index() - 1, secondPath, differences(a, b).c_str());
+        }
+        for (const TraceRecord& rec : recent)
+            printRecord("  ", rec);
+        if (hasA) printRecord("< ", a);
+        if (hasB) printRecord("> ", b);
+        return 1;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        usage();
+        return 1;
+    }
+    std::string command = argv[1];
+    int paths = command == "dump" ? 1 : command == "filter" || command == "diff" ? 2 : 0;
+    if (paths == 0 || argc < 2 + paths) {
+        usage();
+        return 1;
+    }
+
+    PcRange range;
+    bool hasRange = false;
+    uint64_t limit = UINT64_MAX;
+    size_t context = 8;
+    for (int i = 2 + paths; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--pc" && hasValue && parseRange(argv[i + 1], range)) {
+            hasRange = true;
+            i++;
+        } else if (arg == "--limit" && hasValue && command == "dump") {
+            limit = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--context" && hasValue && command == "diff") {
+            context = strtoul(argv[++i], nullptr, 10);
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (command == "dump")
+        return dump(argv[2], range, limit);
+    if (command == "filter") {
+        if (!hasRange) {
+            usage();
+            return 1;
+        }
+        return filter(argv[2], argv[3], range);
+    }
+    return diff(argv[2], argv[3], range, context);
+}